@@ -0,0 +1,18 @@
+#pragma once
+// MemTrack readout for the benches: what a timed loop allocated, per subsystem tag.
+// Tags the loop never touched are left out.
+#include "../src/utils/MemTrack.h"
+#include <cstdio>
+
+inline void PrintAllocs(const char* label, const MemTrack::Snapshot& before, const MemTrack::Snapshot& after, int iterations) {
+    printf("  %-10s", label);
+    bool any = false;
+    for (int i = 0; i < (int)MemTag::Count; i++) {
+        uint64_t allocs = after.allocs[i] - before.allocs[i];
+        if (allocs == 0) continue;
+        printf(" %s: %.1f allocs/iter, live %.1f KB, peak %.1f KB", MemTrack::Name((MemTag)i),
+               allocs / (double)iterations, after.liveBytes[i] / 1024.0, after.peakBytes[i] / 1024.0);
+        any = true;
+    }
+    printf(any ? "\n" : " no allocations\n");
+}
@@ -0,0 +1,238 @@
+// Section mesher microbenchmark: the bit-parallel BlockESP::UpdateChunk against the
+// per-voxel greedy mesher it replaced (kept below as LegacyMesh, unchanged apart from
+// reading a dense array instead of the cache). Built with -DXAI_BUILD_BENCH=ON.
+#include "../src/modules/BlockESP.h"
+#include "BenchMem.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+
+namespace {
+
+struct LegacyFace { float x1, y1, z1, x2, y2, z2, x3, y3, z3, x4, y4, z4; };
+struct LegacyEdge { float x1, y1, z1, x2, y2, z2; };
+
+struct TempEdge {
+    float x1, y1, z1;
+    float x2, y2, z2;
+    uint16_t color;
+    int axis; // 0=X, 1=Y, 2=Z
+
+    bool operator<(const TempEdge& other) const {
+        if (color != other.color) return color < other.color;
+        if (axis != other.axis) return axis < other.axis;
+        if (axis == 0) {
+            if (y1 != other.y1) return y1 < other.y1;
+            if (z1 != other.z1) return z1 < other.z1;
+            return x1 < other.x1;
+        } else if (axis == 1) {
+            if (x1 != other.x1) return x1 < other.x1;
+            if (z1 != other.z1) return z1 < other.z1;
+            return y1 < other.y1;
+        } else {
+            if (x1 != other.x1) return x1 < other.x1;
+            if (y1 != other.y1) return y1 < other.y1;
+            return z1 < other.z1;
+        }
+    }
+};
+
+// The mask[16][16] greedy mesher with four edges per quad and a sort-and-merge pass.
+// Voxels outside the section count as air, matching a section with no cached neighbours.
+void LegacyMesh(const uint16_t (&data)[16][16][16], std::vector<LegacyFace>& faces, std::vector<LegacyEdge>& edges) {
+    static const int faceDirs[6][3] = {
+        {0, 0, -1}, {1, 0, 0}, {0, 0, 1}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}
+    };
+
+    std::vector<TempEdge> tempEdges;
+    for (int dir = 0; dir < 6; dir++) {
+        for (int d = 0; d < 16; d++) {
+            uint16_t mask[16][16] = {0};
+            for (int v = 0; v < 16; v++) {
+                for (int u = 0; u < 16; u++) {
+                    int lx, ly, lz;
+                    if (dir == 0 || dir == 2) { lx = u; ly = v; lz = d; }
+                    else if (dir == 1 || dir == 3) { lx = d; ly = v; lz = u; }
+                    else { lx = u; ly = d; lz = v; }
+
+                    uint16_t id = data[lx][ly][lz];
+                    if (id == 0) continue;
+
+                    int nx = lx + faceDirs[dir][0];
+                    int ny = ly + faceDirs[dir][1];
+                    int nz = lz + faceDirs[dir][2];
+                    uint16_t neighborId = 0;
+                    if (nx >= 0 && nx < 16 && ny >= 0 && ny < 16 && nz >= 0 && nz < 16) {
+                        neighborId = data[nx][ny][nz];
+                    }
+                    if (neighborId != id) mask[v][u] = id;
+                }
+            }
+
+            bool visited[16][16] = {false};
+            for (int v = 0; v < 16; v++) {
+                for (int u = 0; u < 16; u++) {
+                    if (visited[v][u] || mask[v][u] == 0) continue;
+                    uint16_t id = mask[v][u];
+
+                    int w = 1;
+                    while (u + w < 16 && !visited[v][u + w] && mask[v][u + w] == id) w++;
+
+                    int h = 1;
+                    bool canExtend = true;
+                    while (v + h < 16) {
+                        for (int k = 0; k < w; k++) {
+                            if (visited[v + h][u + k] || mask[v + h][u + k] != id) {
+                                canExtend = false;
+                                break;
+                            }
+                        }
+                        if (!canExtend) break;
+                        h++;
+                    }
+
+                    for (int dy = 0; dy < h; dy++) {
+                        for (int dx = 0; dx < w; dx++) visited[v + dy][u + dx] = true;
+                    }
+
+                    float x1, y1, z1, x2, y2, z2;
+                    if (dir == 0 || dir == 2) {
+                        x1 = (float)u; y1 = (float)v; z1 = (float)d;
+                        x2 = (float)(u + w); y2 = (float)(v + h); z2 = (float)d;
+                        if (dir == 2) { z1 += 1.0f; z2 += 1.0f; }
+                    } else if (dir == 1 || dir == 3) {
+                        x1 = (float)d; y1 = (float)v; z1 = (float)u;
+                        x2 = (float)d; y2 = (float)(v + h); z2 = (float)(u + w);
+                        if (dir == 1) { x1 += 1.0f; x2 += 1.0f; }
+                    } else {
+                        x1 = (float)u; y1 = (float)d; z1 = (float)v;
+                        x2 = (float)(u + w); y2 = (float)d; z2 = (float)(v + h);
+                        if (dir == 4) { y1 += 1.0f; y2 += 1.0f; }
+                    }
+
+                    LegacyFace f;
+                    if (dir == 0)      f = { x2, y1, z1, x1, y1, z1, x1, y2, z1, x2, y2, z1 };
+                    else if (dir == 2) f = { x1, y1, z1, x2, y1, z1, x2, y2, z1, x1, y2, z1 };
+                    else if (dir == 3) f = { x1, y1, z1, x1, y1, z2, x1, y2, z2, x1, y2, z1 };
+                    else if (dir == 1) f = { x1, y1, z2, x1, y1, z1, x1, y2, z1, x1, y2, z2 };
+                    else if (dir == 5) f = { x1, y1, z1, x2, y1, z1, x2, y1, z2, x1, y1, z2 };
+                    else               f = { x1, y1, z2, x2, y1, z2, x2, y1, z1, x1, y1, z1 };
+                    faces.push_back(f);
+
+                    const float* c = &f.x1;
+                    for (int k = 0; k < 4; k++) {
+                        const float* a = c + k * 3;
+                        const float* b = c + ((k + 1) & 3) * 3;
+                        TempEdge e;
+                        e.color = id;
+                        e.x1 = a[0]; e.y1 = a[1]; e.z1 = a[2];
+                        e.x2 = b[0]; e.y2 = b[1]; e.z2 = b[2];
+                        if (e.x1 != e.x2) e.axis = 0; else if (e.y1 != e.y2) e.axis = 1; else e.axis = 2;
+                        if (e.x1 > e.x2 || e.y1 > e.y2 || e.z1 > e.z2) { std::swap(e.x1, e.x2); std::swap(e.y1, e.y2); std::swap(e.z1, e.z2); }
+                        tempEdges.push_back(e);
+                    }
+                }
+            }
+        }
+    }
+
+    std::sort(tempEdges.begin(), tempEdges.end());
+    if (tempEdges.empty()) return;
+
+    TempEdge current = tempEdges[0];
+    for (size_t i = 1; i < tempEdges.size(); i++) {
+        const TempEdge& next = tempEdges[i];
+        bool sameLine = false;
+        if (current.color == next.color && current.axis == next.axis) {
+            if (current.axis == 0)      sameLine = current.y1 == next.y1 && current.z1 == next.z1;
+            else if (current.axis == 1) sameLine = current.x1 == next.x1 && current.z1 == next.z1;
+            else                        sameLine = current.x1 == next.x1 && current.y1 == next.y1;
+        }
+        if (sameLine) {
+            float currEnd = (current.axis == 0) ? current.x2 : ((current.axis == 1) ? current.y2 : current.z2);
+            float nextStart = (next.axis == 0) ? next.x1 : ((next.axis == 1) ? next.y1 : next.z1);
+            if (currEnd >= nextStart - 0.001f) {
+                float nextEnd = (next.axis == 0) ? next.x2 : ((next.axis == 1) ? next.y2 : next.z2);
+                if (nextEnd > currEnd) {
+                    if (current.axis == 0) current.x2 = nextEnd;
+                    else if (current.axis == 1) current.y2 = nextEnd;
+                    else current.z2 = nextEnd;
+                }
+                continue;
+            }
+        }
+        edges.push_back({ current.x1, current.y1, current.z1, current.x2, current.y2, current.z2 });
+        current = next;
+    }
+    edges.push_back({ current.x1, current.y1, current.z1, current.x2, current.y2, current.z2 });
+}
+
+double Ms(std::chrono::steady_clock::time_point since) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+}
+
+} // namespace
+
+// Friend of BlockESP: drives UpdateChunk on a cache holding a single section
+struct BlockESPBench {
+    static void Run(const char* name, int fillPercent, int types, int iterations) {
+        std::mt19937 rng(1234);
+        uint16_t data[16][16][16] = {};
+        std::map<int, uint16_t> blocks;
+        for (int index = 0; index < 4096; index++) {
+            if ((int)(rng() % 100) >= fillPercent) continue;
+            uint16_t id = (uint16_t)(1 + rng() % types);
+            data[index % 16][(index / 16) % 16][index / 256] = id;
+            blocks[index] = id;
+        }
+
+        BlockESP esp(nullptr);
+        esp.shouldStop = true; // The bench meshes on this thread
+        esp.queueCV.notify_all();
+        esp.workerThread.join();
+        for (int i = 0; i < types; i++) esp.GetBlockID("bench_block_" + std::to_string(i));
+        esp.chunkMap[{0, 0, 0}].blocks = blocks;
+
+        // Tagged like the worker thread that meshes in the overlay
+        MemScope memScope(MemTag::BlockESP);
+        MemTrack::Snapshot memStart = MemTrack::Capture();
+
+        size_t legacyQuads = 0, legacyEdges = 0;
+        auto t0 = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; i++) {
+            std::vector<LegacyFace> faces;
+            std::vector<LegacyEdge> edges;
+            LegacyMesh(data, faces, edges);
+            legacyQuads = faces.size();
+            legacyEdges = edges.size();
+        }
+        double legacyMs = Ms(t0);
+        MemTrack::Snapshot memLegacy = MemTrack::Capture();
+
+        size_t quads = 0, edges = 0;
+        t0 = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; i++) {
+            esp.UpdateChunk({0, 0, 0});
+            quads = esp.chunkMap[{0, 0, 0}].mesh->faces.size();
+            edges = esp.chunkMap[{0, 0, 0}].mesh->edges.size();
+        }
+        double bitMs = Ms(t0);
+        MemTrack::Snapshot memBitmask = MemTrack::Capture();
+
+        printf("%-8s %5zu blocks | legacy %6zu quads %6zu edges %8.0f quads/ms | bitmask %6zu quads %6zu edges %8.0f quads/ms | %.1fx\n",
+            name, blocks.size(),
+            legacyQuads, legacyEdges, legacyQuads * iterations / legacyMs,
+            quads, edges, quads * iterations / bitMs,
+            legacyMs / bitMs);
+        PrintAllocs("legacy", memStart, memLegacy, iterations);
+        PrintAllocs("bitmask", memLegacy, memBitmask, iterations);
+    }
+};
+
+int main() {
+    BlockESPBench::Run("dense", 70, 3, 200);
+    BlockESPBench::Run("sparse", 1, 2, 2000);
+    BlockESPBench::Run("solid", 100, 1, 2000);
+    return 0;
+}
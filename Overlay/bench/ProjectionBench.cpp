@@ -0,0 +1,89 @@
+// Projection throughput: ProjectBatch (SSE when MATHUTILS_SSE) against the scalar
+// WorldToCamera / CameraToScreen / FrustumOutcode path it replaced in the renderers.
+// Built with -DXAI_BUILD_BENCH=ON.
+#include "../src/MathUtils.h"
+#include "BenchMem.h"
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+namespace {
+
+double Ms(std::chrono::steady_clock::time_point since) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+}
+
+void Run(const char* name, const ViewState& vs, size_t points, int iterations) {
+    const float nearZ = 0.1f;
+
+    // Camera-relative points around the player, like the block and entity renderers push
+    std::mt19937 rng(99);
+    std::uniform_real_distribution<float> coord(-128.0f, 128.0f);
+    ProjectionBatch batch;
+    for (size_t i = 0; i < points; i++) batch.Push(coord(rng), coord(rng) * 0.25f, coord(rng));
+
+    std::vector<Vec2> screen(points);
+    std::vector<uint8_t> outcodes(points);
+    double checksum = 0.0;
+
+    MemTrack::Snapshot memStart = MemTrack::Capture();
+    auto t0 = std::chrono::steady_clock::now();
+    for (int it = 0; it < iterations; it++) {
+        for (size_t i = 0; i < points; i++) {
+            Vec3 c = WorldToCamera(batch.x[i], batch.y[i], batch.z[i], vs);
+            screen[i] = CameraToScreen(c, vs);
+            outcodes[i] = (uint8_t)FrustumOutcode(c, vs, nearZ);
+        }
+        checksum += screen[it % points].x;
+    }
+    double scalarMs = Ms(t0);
+    MemTrack::Snapshot memScalar = MemTrack::Capture();
+
+    t0 = std::chrono::steady_clock::now();
+    for (int it = 0; it < iterations; it++) {
+        ProjectBatch(batch, vs, nearZ);
+        checksum += batch.screenX[it % points];
+    }
+    double batchMs = Ms(t0);
+    MemTrack::Snapshot memBatch = MemTrack::Capture();
+
+    // Both paths must agree on what is visible
+    size_t mismatched = 0;
+    for (size_t i = 0; i < points; i++) {
+        if (outcodes[i] != batch.outcodes[i]) mismatched++;
+    }
+
+    double total = (double)points * iterations;
+    printf("%-10s %7zu points | scalar %8.1f Mpts/s | batch %8.1f Mpts/s | %.1fx | outcode mismatches %zu (checksum %.0f)\n",
+        name, points, total / scalarMs / 1000.0, total / batchMs / 1000.0, scalarMs / batchMs, mismatched, checksum);
+    PrintAllocs("scalar", memStart, memScalar, iterations);
+    PrintAllocs("batch", memScalar, memBatch, iterations);
+}
+
+} // namespace
+
+int main() {
+#ifdef MATHUTILS_SSE
+    printf("ProjectBatch: SSE\n");
+#else
+    printf("ProjectBatch: scalar fallback\n");
+#endif
+
+    ViewState yawPitch = PrecomputeViewState(37.0f, 12.0f, 70.0f, 1920.0f, 1080.0f);
+
+    // A plain perspective * look matrix, column-major like the mod sends it
+    const float f = 1.0f / tanf(35.0f * 3.14159f / 180.0f), aspect = 1920.0f / 1080.0f;
+    const float viewProj[16] = {
+        f / aspect, 0.0f, 0.0f, 0.0f,
+        0.0f, f, 0.0f, 0.0f,
+        0.0f, 0.0f, -1.0002f, -1.0f,
+        0.0f, 0.0f, -0.2f, 0.0f,
+    };
+    ViewState matrix = PrecomputeViewState(viewProj, 1920.0f, 1080.0f);
+
+    Run("yaw/pitch", yawPitch, 4096, 2000);
+    Run("yaw/pitch", yawPitch, 262144, 40);
+    Run("matrix", matrix, 4096, 2000);
+    Run("matrix", matrix, 262144, 40);
+    return 0;
+}
@@ -1,43 +1,136 @@
 #pragma once
 #include <cmath>
+#include <cstdint>
+#include <vector>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#if defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#include <emmintrin.h>
+#define MATHUTILS_SSE 1
+#endif
+
+// Count trailing zeros. v must be non-zero.
+inline int Ctz32(uint32_t v) {
+#ifdef _MSC_VER
+    unsigned long idx;
+    _BitScanForward(&idx, v);
+    return (int)idx;
+#else
+    return __builtin_ctz(v);
+#endif
+}
 
 struct Vec2 { float x, y; };
 struct Vec3 { float x, y, z; };
 
+// "Camera space" here is whatever the projection divides by: x and y are scaled by
+// tanHalfFov/aspectRatio in CameraToScreen and z is the view depth used for clipping.
+// Both view sources reduce to one affine transform of camera-relative coordinates:
+//  - yaw/pitch/FOV: the two rotations, with the FOV applied in CameraToScreen
+//  - game matrix:   rows x, y and w of the view-projection, so z is clip w and the
+//                   FOV/aspect are already applied (tanHalfFov = aspectRatio = 1)
 struct ViewState {
-    float cosYaw, sinYaw;
-    float cosPitch, sinPitch;
+    float rows[3][4];     // Camera x, y, z = rows[i][0..2] . p + rows[i][3]
     float tanHalfFov;
     float aspectRatio;
     float screenW, screenH;
+    float guardX, guardY; // Frustum side slopes (|x|/z, |y|/z) widened by a few pixels of guard band
 };
 
+// Pixels outside the screen edge that still count as visible (line width, AA fringe)
+constexpr float kGuardBandPx = 4.0f;
+
 inline ViewState PrecomputeViewState(float yaw, float pitch, float fov, float screenW, float screenH) {
     float yawRad = -yaw * (3.14159f / 180.0f);
     float pitchRad = -pitch * (3.14159f / 180.0f);
     float fovRad = fov * (3.14159f / 180.0f);
 
-    return {
-        cos(yawRad), sin(yawRad),
-        cos(pitchRad), sin(pitchRad),
-        tan(fovRad / 2.0f),
-        screenW / screenH,
-        screenW, screenH
+    float cy = cosf(yawRad), sy = sinf(yawRad);
+    float cp = cosf(pitchRad), sp = sinf(pitchRad);
+    float tanHalfFov = tanf(fovRad / 2.0f);
+    float aspect = screenW / screenH;
+
+    ViewState vs = {
+        {
+            // Yaw around Y, then pitch around X
+            { -cy,      0.0f, sy,       0.0f },
+            { -sp * sy, cp,   -sp * cy, 0.0f },
+            { cp * sy,  sp,   cp * cy,  0.0f },
+        },
+        tanHalfFov,
+        aspect,
+        screenW, screenH,
+        tanHalfFov * aspect * (1.0f + 2.0f * kGuardBandPx / screenW),
+        tanHalfFov * (1.0f + 2.0f * kGuardBandPx / screenH)
     };
+    return vs;
+}
+
+// From the game's view-projection matrix (column-major, camera-relative input, OpenGL clip space).
+// Follows the game frame exactly, including view bobbing, roll and FOV effects.
+inline ViewState PrecomputeViewState(const float viewProj[16], float screenW, float screenH) {
+    ViewState vs = {
+        {
+            { viewProj[0], viewProj[4], viewProj[8],  viewProj[12] }, // clip x
+            { viewProj[1], viewProj[5], viewProj[9],  viewProj[13] }, // clip y
+            { viewProj[3], viewProj[7], viewProj[11], viewProj[15] }, // clip w (view depth)
+        },
+        1.0f,
+        1.0f,
+        screenW, screenH,
+        1.0f + 2.0f * kGuardBandPx / screenW,
+        1.0f + 2.0f * kGuardBandPx / screenH
+    };
+    return vs;
 }
 
 inline Vec3 WorldToCamera(float x, float y, float z, const ViewState& vs) {
-    // 1. Yaw Rotation (Y-axis)
-    float x1 = -(x * vs.cosYaw - z * vs.sinYaw);
-    float z1 = x * vs.sinYaw + z * vs.cosYaw;
-    float y1 = y;
+    return {
+        vs.rows[0][0] * x + vs.rows[0][1] * y + vs.rows[0][2] * z + vs.rows[0][3],
+        vs.rows[1][0] * x + vs.rows[1][1] * y + vs.rows[1][2] * z + vs.rows[1][3],
+        vs.rows[2][0] * x + vs.rows[2][1] * y + vs.rows[2][2] * z + vs.rows[2][3]
+    };
+}
+
+// Approximate on-screen height in pixels of a world-space length at a given view depth.
+// The y row's length is 1 for yaw/pitch and carries the FOV scale for the game matrix.
+inline float ProjectedSize(float length, float depth, const ViewState& vs) {
+    float yScale = sqrtf(vs.rows[1][0] * vs.rows[1][0] + vs.rows[1][1] * vs.rows[1][1] + vs.rows[1][2] * vs.rows[1][2]);
+    return length * yScale / (vs.tanHalfFov * depth) * 0.5f * vs.screenH;
+}
+
+// Frustum outcodes for a camera-space point: one bit per plane the point is outside of.
+// A primitive whose vertices all share a bit is entirely off-screen and can be skipped
+// before projecting. Side planes include the guard band; there is no far plane.
+enum FrustumOut { OutNear = 1, OutLeft = 2, OutRight = 4, OutBottom = 8, OutTop = 16 };
+
+inline int FrustumOutcode(const Vec3& p, const ViewState& vs, float nearZ) {
+    float limX = p.z * vs.guardX;
+    float limY = p.z * vs.guardY;
+    return (p.z < nearZ ? OutNear : 0) |
+           (p.x < -limX ? OutLeft : 0) | (p.x > limX ? OutRight : 0) |
+           (p.y < -limY ? OutBottom : 0) | (p.y > limY ? OutTop : 0);
+}
+
+// Conservative frustum test for a world-aligned box given relative to the camera.
+// The box is moved into camera space as centre + projected radius per axis, then
+// tested against the near and (guard-banded) side planes. Far distance is left to the caller.
+inline bool AabbInFrustum(const Vec3& center, const Vec3& half, const ViewState& vs, float nearZ) {
+    Vec3 c = WorldToCamera(center.x, center.y, center.z, vs);
 
-    // 2. Pitch Rotation (X-axis)
-    float y2 = y1 * vs.cosPitch - z1 * vs.sinPitch;
-    float z2 = y1 * vs.sinPitch + z1 * vs.cosPitch;
-    float x2 = x1;
-    
-    return {x2, y2, z2};
+    // |M| * half: how far the box reaches along each camera axis
+    float ex = fabsf(vs.rows[0][0]) * half.x + fabsf(vs.rows[0][1]) * half.y + fabsf(vs.rows[0][2]) * half.z;
+    float ey = fabsf(vs.rows[1][0]) * half.x + fabsf(vs.rows[1][1]) * half.y + fabsf(vs.rows[1][2]) * half.z;
+    float ez = fabsf(vs.rows[2][0]) * half.x + fabsf(vs.rows[2][1]) * half.y + fabsf(vs.rows[2][2]) * half.z;
+
+    if (c.z + ez < nearZ) return false;
+    // Side plane n = (-1, 0, k) (right); box is outside when n.c + |n|.e < 0
+    if (vs.guardX * c.z - c.x + ex + vs.guardX * ez < 0) return false; // Right
+    if (vs.guardX * c.z + c.x + ex + vs.guardX * ez < 0) return false; // Left
+    if (vs.guardY * c.z - c.y + ey + vs.guardY * ez < 0) return false; // Top
+    if (vs.guardY * c.z + c.y + ey + vs.guardY * ez < 0) return false; // Bottom
+    return true;
 }
 
 inline Vec2 CameraToScreen(const Vec3& p, const ViewState& vs) {
@@ -61,3 +154,100 @@ inline Vec2 WorldToScreen(float x, float y, float z, float yaw, float pitch, flo
     auto vs = PrecomputeViewState(yaw, pitch, fov, screenW, screenH);
     return WorldToScreen(x, y, z, vs);
 }
+
+// Batched projection. Points go in as SoA camera-relative world coordinates and come out
+// as camera space, screen space (-10000 sentinel like CameraToScreen) and frustum outcodes.
+// Fill x/y/z with Push(), call ProjectBatch(), read results by index. Buffers keep their
+// capacity across Clear() so a per-frame batch stops allocating after the first frames.
+struct ProjectionBatch {
+    std::vector<float> x, y, z;          // Input
+    std::vector<float> camX, camY, camZ; // WorldToCamera
+    std::vector<float> screenX, screenY; // CameraToScreen
+    std::vector<uint8_t> outcodes;       // FrustumOutcode
+
+    void Clear() { x.clear(); y.clear(); z.clear(); }
+    void Push(float px, float py, float pz) { x.push_back(px); y.push_back(py); z.push_back(pz); }
+    size_t Size() const { return x.size(); }
+
+    Vec3 Camera(size_t i) const { return { camX[i], camY[i], camZ[i] }; }
+    Vec2 Screen(size_t i) const { return { screenX[i], screenY[i] }; }
+};
+
+// Scalar reference for one point, also used for the SIMD tail
+inline void ProjectPoint(const ProjectionBatch& b, size_t i, const ViewState& vs, float nearZ,
+                         float* camX, float* camY, float* camZ, float* screenX, float* screenY, uint8_t* outcodes) {
+    Vec3 c = WorldToCamera(b.x[i], b.y[i], b.z[i], vs);
+    Vec2 s = CameraToScreen(c, vs);
+    camX[i] = c.x; camY[i] = c.y; camZ[i] = c.z;
+    screenX[i] = s.x; screenY[i] = s.y;
+    outcodes[i] = (uint8_t)FrustumOutcode(c, vs, nearZ);
+}
+
+inline void ProjectBatch(ProjectionBatch& b, const ViewState& vs, float nearZ) {
+    size_t n = b.Size();
+    b.camX.resize(n); b.camY.resize(n); b.camZ.resize(n);
+    b.screenX.resize(n); b.screenY.resize(n);
+    b.outcodes.resize(n);
+    if (n == 0) return;
+
+    float* camX = b.camX.data(); float* camY = b.camY.data(); float* camZ = b.camZ.data();
+    float* screenX = b.screenX.data(); float* screenY = b.screenY.data();
+    uint8_t* outcodes = b.outcodes.data();
+    size_t i = 0;
+
+#ifdef MATHUTILS_SSE
+    // Same operation order as WorldToCamera/CameraToScreen, 4 points per iteration
+    __m128 m[3][4];
+    for (int r = 0; r < 3; r++) {
+        for (int c = 0; c < 4; c++) m[r][c] = _mm_set1_ps(vs.rows[r][c]);
+    }
+    const __m128 tanX = _mm_set1_ps(vs.tanHalfFov * vs.aspectRatio), tanY = _mm_set1_ps(vs.tanHalfFov);
+    const __m128 guardX = _mm_set1_ps(vs.guardX), guardY = _mm_set1_ps(vs.guardY);
+    const __m128 scrW = _mm_set1_ps(vs.screenW), scrH = _mm_set1_ps(vs.screenH);
+    const __m128 half = _mm_set1_ps(0.5f), zero = _mm_setzero_ps();
+    const __m128 minZ = _mm_set1_ps(0.05f), near4 = _mm_set1_ps(nearZ);
+    const __m128 sentinel = _mm_set1_ps(-10000.0f);
+
+    for (; i + 4 <= n; i += 4) {
+        __m128 x = _mm_loadu_ps(&b.x[i]);
+        __m128 y = _mm_loadu_ps(&b.y[i]);
+        __m128 z = _mm_loadu_ps(&b.z[i]);
+
+        // One affine transform (rotation or view-projection rows)
+        __m128 x1 = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(m[0][0], x), _mm_mul_ps(m[0][1], y)), _mm_mul_ps(m[0][2], z)), m[0][3]);
+        __m128 y2 = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(m[1][0], x), _mm_mul_ps(m[1][1], y)), _mm_mul_ps(m[1][2], z)), m[1][3]);
+        __m128 z2 = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(m[2][0], x), _mm_mul_ps(m[2][1], y)), _mm_mul_ps(m[2][2], z)), m[2][3]);
+
+        _mm_storeu_ps(&camX[i], x1);
+        _mm_storeu_ps(&camY[i], y2);
+        _mm_storeu_ps(&camZ[i], z2);
+
+        // Projection; lanes behind the camera get the sentinel
+        __m128 sx = _mm_add_ps(_mm_mul_ps(_mm_div_ps(x1, _mm_mul_ps(z2, tanX)), half), half);
+        __m128 sy = _mm_sub_ps(half, _mm_mul_ps(_mm_div_ps(y2, _mm_mul_ps(z2, tanY)), half));
+        __m128 behind = _mm_cmplt_ps(z2, minZ);
+        sx = _mm_or_ps(_mm_and_ps(behind, sentinel), _mm_andnot_ps(behind, _mm_mul_ps(sx, scrW)));
+        sy = _mm_or_ps(_mm_and_ps(behind, sentinel), _mm_andnot_ps(behind, _mm_mul_ps(sy, scrH)));
+        _mm_storeu_ps(&screenX[i], sx);
+        _mm_storeu_ps(&screenY[i], sy);
+
+        // Outcodes, one movemask per plane
+        __m128 limX = _mm_mul_ps(z2, guardX);
+        __m128 limY = _mm_mul_ps(z2, guardY);
+        int mNear = _mm_movemask_ps(_mm_cmplt_ps(z2, near4));
+        int mLeft = _mm_movemask_ps(_mm_cmplt_ps(x1, _mm_sub_ps(zero, limX)));
+        int mRight = _mm_movemask_ps(_mm_cmpgt_ps(x1, limX));
+        int mBottom = _mm_movemask_ps(_mm_cmplt_ps(y2, _mm_sub_ps(zero, limY)));
+        int mTop = _mm_movemask_ps(_mm_cmpgt_ps(y2, limY));
+        for (int l = 0; l < 4; l++) {
+            outcodes[i + l] = (uint8_t)((((mNear >> l) & 1) ? OutNear : 0) |
+                                        (((mLeft >> l) & 1) ? OutLeft : 0) | (((mRight >> l) & 1) ? OutRight : 0) |
+                                        (((mBottom >> l) & 1) ? OutBottom : 0) | (((mTop >> l) & 1) ? OutTop : 0));
+        }
+    }
+#endif
+
+    for (; i < n; i++) {
+        ProjectPoint(b, i, vs, nearZ, camX, camY, camZ, screenX, screenY, outcodes);
+    }
+}
@@ -1,4 +1,9 @@
 #include "TextureManager.h"
+#include "utils/MemTrack.h"
+// Decode buffers are charged to the texture caches like the rest of their allocations
+#define STBI_MALLOC(sz) MemTrack::Alloc(sz, MemTag::Textures)
+#define STBI_REALLOC(p, newsz) MemTrack::Realloc(p, newsz, MemTag::Textures)
+#define STBI_FREE(p) MemTrack::Free(p)
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 #include <filesystem>
@@ -13,6 +18,7 @@ void TextureManager::Initialize(ID3D11Device* device) {
 }
 
 ID3D11ShaderResourceView* TextureManager::GetTexture(const std::string& itemId) {
+    MemScope memScope(MemTag::Textures);
     if (textureCache.find(itemId) != textureCache.end()) {
         return textureCache[itemId];
     }
@@ -36,6 +42,7 @@ ID3D11ShaderResourceView* TextureManager::GetTexture(const std::string& itemId)
 }
 
 ID3D11ShaderResourceView* TextureManager::GetBlockTexture(const std::string& blockId) {
+    MemScope memScope(MemTag::Textures);
     if (blockTextureCache.find(blockId) != blockTextureCache.end()) {
         return blockTextureCache[blockId];
     }
@@ -96,5 +103,6 @@ ID3D11ShaderResourceView* TextureManager::LoadTextureFromFile(const std::string&
 
     if (FAILED(hr)) return nullptr;
 
+    MemTrack::AddGpuBytes(MemTag::Textures, (int64_t)width * height * 4);
     return srv;
 }
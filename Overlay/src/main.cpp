@@ -21,6 +21,7 @@
 #include "modules/Friends.h"
 #include "modules/PlayerESP.h"
 #include "MathUtils.h"
+#include "utils/MemTrack.h"
 
 // Link DirectX
 #pragma comment(lib, "d3d11.lib")
@@ -46,13 +47,25 @@ bool CreateDeviceD3D(HWND hWnd);
 void CleanupDeviceD3D();
 void CreateRenderTarget();
 void CleanupRenderTarget();
+void UpdateMemoryStats();
+void DrawMemoryHud(ImDrawList* draw, float screenW, float screenH);
 
 // Performance Debugging
 long long totalRenderTime = 0;
 long long totalNametagTime = 0;
+long long totalProjectTime = 0; // ns
+ProjectionBatch entityProjection; // Entity box corners, reused every frame
 int renderFrames = 0;
 std::chrono::steady_clock::time_point lastRenderDebugTime = std::chrono::steady_clock::now();
 
+// Memory Debugging (MemTrack): allocations per frame = difference of two snapshots
+MemTrack::Snapshot lastMemSnapshot = {};
+uint64_t frameAllocs[(int)MemTag::Count] = {};    // Last completed frame
+uint64_t maxFrameAllocs[(int)MemTag::Count] = {}; // Worst frame since the last print
+uint64_t totalFrameAllocs[(int)MemTag::Count] = {};
+int memFrames = 0;
+std::chrono::steady_clock::time_point lastMemDebugTime = std::chrono::steady_clock::now();
+
 #include "utils/IconLoader.h"
 
 // Forward declarations of helper functions
@@ -121,6 +134,7 @@ int main(int, char**)
 
     // Setup ImGui
     IMGUI_CHECKVERSION();
+    ImGui::SetAllocatorFunctions(MemTrack::ImGuiAlloc, MemTrack::ImGuiFree);
     ImGui::CreateContext();
     ImGuiIO& io = ImGui::GetIO(); (void)io;
     ImGui::StyleColorsDark();
@@ -192,6 +206,8 @@ int main(int, char**)
         }
         if (done) break;
 
+        UpdateMemoryStats();
+
         // Toggle Menu Key (Right Shift)
         if (GetAsyncKeyState(VK_RSHIFT) & 1) {
             showMenu = !showMenu;
@@ -260,23 +276,45 @@ int main(int, char**)
         ImDrawList* bgDrawList = ImGui::GetBackgroundDrawList();
 
         // Render Blocks
+        blockEspModule->Update(&data);
         if (isFocused && !data.isScreenOpen && blockEspModule->enabled) {
             blockEspModule->Render(data, (float)screenW, (float)screenH, bgDrawList);
         }
 
         // Clear processed block updates to prevent accumulation
         data.blockUpdates.clear();
+        data.sectionBlocks.clear();
         data.blocksToDelete.clear();
         data.chunksToUnload.clear();
         data.shouldClearBlocks = false;
+        data.worldSplit = false;
 
         // Render Entities (Hide if not focused OR screen is open)
         if (isFocused && !data.isScreenOpen && (espModule->enabled || nametagsModule->enabled || playerEspModule->enabled)) {
+            MemScope memScope(MemTag::EntityCache); // Projection batch, per-entity draw data
             auto tRenderStart = std::chrono::high_resolution_clock::now();
             long long frameNametagTime = 0;
 
             ImDrawList* draw = bgDrawList;
+
+            // Project all bounding box corners in one batch (8 per entity, same order as 'points' below)
+            ViewState viewState = data.hasViewProj ? PrecomputeViewState(data.viewProj, (float)screenW, (float)screenH)
+                                                   : PrecomputeViewState(data.camYaw, data.camPitch, data.fov, (float)screenW, (float)screenH);
+            entityProjection.Clear();
             for (const auto& e : data.entities) {
+                float w2 = e.w / 2.0f;
+                for (int k = 0; k < 8; k++) {
+                    entityProjection.Push((k & 1) ? e.x + w2 : e.x - w2, (k & 4) ? e.y + e.h : e.y, (k & 2) ? e.z + w2 : e.z - w2);
+                }
+            }
+            auto tProjectStart = std::chrono::high_resolution_clock::now();
+            ProjectBatch(entityProjection, viewState, 0.05f);
+            totalProjectTime += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - tProjectStart).count();
+
+            size_t entityIndex = 0;
+            for (const auto& e : data.entities) {
+                size_t cornerBase = 8 * entityIndex++;
+
                 // Optimization Check
                 if (!e.shouldRender && !e.shouldRenderNametag) continue;
 
@@ -299,18 +337,10 @@ int main(int, char**)
                 if (z2 <= 0.5f) continue; // 0.5f buffer
                 */
 
-                // Calculate 3D Bounding Box Corners
+                // 3D Bounding Box Corners (projected above, index = cornerBase + i)
+                // 0: Bottom-Left-North, 1: Bottom-Right-North, 2: Bottom-Left-South, 3: Bottom-Right-South
+                // 4: Top-Left-North,    5: Top-Right-North,    6: Top-Left-South,    7: Top-Right-South
                 float w2 = e.w / 2.0f;
-                float points[8][3] = {
-                    { e.x - w2, e.y,       e.z - w2 }, // 0: Bottom-Left-North
-                    { e.x + w2, e.y,       e.z - w2 }, // 1: Bottom-Right-North
-                    { e.x - w2, e.y,       e.z + w2 }, // 2: Bottom-Left-South
-                    { e.x + w2, e.y,       e.z + w2 }, // 3: Bottom-Right-South
-                    { e.x - w2, e.y + e.h, e.z - w2 }, // 4: Top-Left-North
-                    { e.x + w2, e.y + e.h, e.z - w2 }, // 5: Top-Right-North
-                    { e.x - w2, e.y + e.h, e.z + w2 }, // 6: Top-Left-South
-                    { e.x + w2, e.y + e.h, e.z + w2 }  // 7: Top-Right-South
-                };
 
                 // Define Faces (Vertex Indices)
                 // Order: Bottom, Top, North, South, West, East
@@ -362,7 +392,7 @@ int main(int, char**)
                         bool allValid = true;
                         for (int j = 0; j < 4; j++) {
                             int idx = faces[i][j];
-                            screenPoints[j] = WorldToScreen(points[idx][0], points[idx][1], points[idx][2], data.camYaw, data.camPitch, data.fov, (float)screenW, (float)screenH);
+                            screenPoints[j] = entityProjection.Screen(cornerBase + idx);
                             if (screenPoints[j].x <= -10000) allValid = false;
                             
                             // Update BBox for nametags (use any valid point we find)
@@ -407,16 +437,19 @@ int main(int, char**)
             if (std::chrono::duration_cast<std::chrono::seconds>(now - lastRenderDebugTime).count() >= 1) {
                 double avgRender = (totalRenderTime / (double)renderFrames) / 1000.0;
                 double avgNametag = (totalNametagTime / (double)renderFrames) / 1000.0;
-                printf("[Perf] C++: Render=%.2fms (Nametags=%.2fms)\n", avgRender, avgNametag);
+                double avgProject = (totalProjectTime / (double)renderFrames) / 1000.0;
+                printf("[Perf] C++: Render=%.2fms (Nametags=%.2fms, Projection=%.1fus)\n", avgRender, avgNametag, avgProject);
                 lastRenderDebugTime = now;
                 totalRenderTime = 0;
                 totalNametagTime = 0;
+                totalProjectTime = 0;
                 renderFrames = 0;
             }
         }
 
         // Draw Menu (Hide if not focused)
         if (showMenu && isFocused) {
+            DrawMemoryHud(bgDrawList, (float)screenW, (float)screenH);
             if (clickGui.Render()) {
                 if (disableModule->enabled) {
                     // Send Disable Packet
@@ -502,6 +535,54 @@ void CleanupRenderTarget()
     if (g_mainRenderTargetView) { g_mainRenderTargetView->Release(); g_mainRenderTargetView = NULL; }
 }
 
+// Called once per frame: allocation counts of the frame that just finished, plus a [Perf] line every second
+void UpdateMemoryStats()
+{
+    MemTrack::Snapshot snap = MemTrack::Capture();
+    for (int i = 0; i < (int)MemTag::Count; i++) {
+        frameAllocs[i] = snap.allocs[i] - lastMemSnapshot.allocs[i];
+        totalFrameAllocs[i] += frameAllocs[i];
+        maxFrameAllocs[i] = (std::max)(maxFrameAllocs[i], frameAllocs[i]);
+    }
+    lastMemSnapshot = snap;
+    memFrames++;
+
+    auto now = std::chrono::steady_clock::now();
+    if (std::chrono::duration_cast<std::chrono::seconds>(now - lastMemDebugTime).count() >= 1) {
+        printf("[Perf] Mem:");
+        for (int i = 0; i < (int)MemTag::Count; i++) {
+            printf(" %s=%.1fMB (peak %.1fMB, %.1f/%llu allocs/frame avg/max)", MemTrack::Name((MemTag)i),
+                   snap.liveBytes[i] / (1024.0 * 1024.0), snap.peakBytes[i] / (1024.0 * 1024.0),
+                   totalFrameAllocs[i] / (double)memFrames, (unsigned long long)maxFrameAllocs[i]);
+            if (snap.gpuBytes[i] > 0) printf(" +%.1fMB GPU", snap.gpuBytes[i] / (1024.0 * 1024.0));
+            totalFrameAllocs[i] = 0;
+            maxFrameAllocs[i] = 0;
+        }
+        printf("\n");
+        memFrames = 0;
+        lastMemDebugTime = now;
+    }
+}
+
+// Bottom-right readout of the MemTrack figures while the menu is open
+void DrawMemoryHud(ImDrawList* draw, float screenW, float screenH)
+{
+    const float lineH = ImGui::GetTextLineHeight();
+    float y = screenH - 24 - lineH * (int)MemTag::Count;
+    for (int i = 0; i < (int)MemTag::Count; i++) {
+        char line[128];
+        int n = snprintf(line, sizeof(line), "%s: %.1f MB (peak %.1f MB) | %llu allocs/frame", MemTrack::Name((MemTag)i),
+                         lastMemSnapshot.liveBytes[i] / (1024.0 * 1024.0), lastMemSnapshot.peakBytes[i] / (1024.0 * 1024.0),
+                         (unsigned long long)frameAllocs[i]);
+        if (lastMemSnapshot.gpuBytes[i] > 0 && n > 0 && n < (int)sizeof(line)) {
+            snprintf(line + n, sizeof(line) - n, " | +%.1f MB GPU", lastMemSnapshot.gpuBytes[i] / (1024.0 * 1024.0));
+        }
+        float w = ImGui::CalcTextSize(line).x;
+        draw->AddText(ImVec2(screenW - w - 10, y), IM_COL32(200, 200, 200, 220), line);
+        y += lineH;
+    }
+}
+
 extern IMGUI_IMPL_API LRESULT ImGui_ImplWin32_WndProcHandler(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam);
 
 LRESULT WINAPI WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
@@ -2,10 +2,11 @@
 #include <iostream>
 #include <sstream>
 #include <chrono>
-#include <set>
+#include <fstream>
 #include "../stb_image.h"
 #include "../utils/DataLists.h"
 #include "../utils/IconLoader.h"
+#include "../utils/MemTrack.h"
 
 namespace fs = std::filesystem;
 
@@ -136,6 +137,11 @@ BlockESP::~BlockESP() {
     if (workerThread.joinable()) {
         workerThread.join();
     }
+
+    // Worker has stopped, so the cache can be written from here
+    if (cacheDirty && !cacheFile.empty()) {
+        SaveWorldCache(cacheFile);
+    }
 }
 
 // Helper to strip suffixes
@@ -222,17 +228,40 @@ void BlockESP::LoadAvailableBlocks() {
 }
 
 void BlockESP::RenderSettings() {
+    FlushTypeChanges();
+
     ImGui::SliderInt("Render Range (Blocks)", &renderRange, 16, 512);
+    ImGui::SliderFloat("Frame Budget (ms)", &frameBudgetMs, 1.0f, 16.0f, "%.1f");
+    ImGui::Checkbox("Adaptive Range", &adaptiveRange);
+    ImGui::SliderInt("Memory Budget (MB)", &memoryBudgetMB, 32, 2048);
+    bool seams = quadSeams.load();
+    if (ImGui::Checkbox("Quad Seams", &seams)) {
+        quadSeams = seams;
+        PendingBatch().remeshAll = true;
+    }
     ImGui::InputText("Search", searchFilter, IM_ARRAYSIZE(searchFilter));
     ImGui::SameLine();
     ImGui::Checkbox("Show Selected", &onlyShowSelected);
     
     if (ImGui::Button("Clear Cache")) {
-        {
-            std::unique_lock<std::shared_mutex> lock(chunkMapMutex);
-            chunkMap.clear();
+        ClearCache(); // The types are unchanged, the manifest alone brings the columns back
+    }
+
+    if (ImGui::CollapsingHeader("Nearest Veins")) {
+        ImGui::SliderInt("Count", &nearestVeinCount, 1, 20);
+        // Any enabled type, or just the one being colour picked
+        std::vector<bool> visible(paletteColors.size());
+        for (size_t i = 0; i < paletteColors.size(); i++) visible[i] = paletteColors[i].visible;
+        std::vector<VeinCluster> veins = NearestVeins(showColorPicker ? editingBlock : "", viewX, viewY, viewZ, (size_t)nearestVeinCount, &visible);
+        if (veins.empty()) ImGui::TextDisabled("No veins cached");
+        for (const auto& vein : veins) {
+            double dx = vein.centerX - viewX, dy = vein.centerY - viewY, dz = vein.centerZ - viewZ;
+            ImGui::TextColored(ImGui::ColorConvertU32ToFloat4(paletteColors[vein.color].edge), "%s x%u",
+                               FormatName(GetBlockName(vein.color)).c_str(), vein.voxels);
+            ImGui::SameLine();
+            ImGui::Text("%.0fm at %d %d %d", sqrt(dx * dx + dy * dy + dz * dz),
+                        (int)std::floor(vein.centerX), (int)std::floor(vein.centerY), (int)std::floor(vein.centerZ));
         }
-        SendUpdate();
     }
 
     float windowVisibleX2 = ImGui::GetWindowPos().x + ImGui::GetWindowContentRegionMax().x;
@@ -297,14 +326,19 @@ void BlockESP::RenderSettings() {
                     }
                     blocks[blockId].colorInitialized = true;
                 }
+            }
+            UpdatePaletteColor(blockId); // Shows/hides the type immediately
+
+            if (blocks[blockId].enabled) {
+                pendingTypeAdds.insert(blockId);
             } else {
-                // Remove this specific block type from local cache immediately
+                // Remove this specific block type from local cache in the background; the mod is
+                // only told to stop streaming it, nothing comes back
                 RemoveBlocks(blockId);
+                pendingTypeAdds.erase(blockId);
+                pendingTypeRemoves.insert(blockId);
             }
-            
-            // Update meshes
-            RebuildAllChunks();
-            SendUpdate();
+            lastTypeToggle = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
         }
         
         if (isEnabled) {
@@ -338,19 +372,32 @@ void BlockESP::RenderSettings() {
         ImGui::Text("Color for %s", FormatName(editingBlock).c_str());
         if (ImGui::ColorPicker3("Color", blocks[editingBlock].color)) {
              blocks[editingBlock].colorInitialized = true; // Mark as initialized/custom
-             RebuildAllChunks();
+             UpdatePaletteColor(editingBlock);
         }
         ImGui::EndPopup();
     }
 }
 
 void BlockESP::OnToggle() {
-    // Reset local data and force resync from server
+    // Reset local data. The block list goes to the mod as empty when disabled and full when
+    // enabled, so it drops every type and then scans them all anew: that alone resends the
+    // world, a manifest on top would send it twice.
+    ClearCache(false);
+    SendUpdate();
+}
+
+void BlockESP::Update(const GameData* data) {
+    if (enabled) return; // Render takes the network data
+    // Disabled: hand the clear from OnToggle to the worker so the cache is freed now, and drop
+    // what the worker still had for the mod. The frame's block data is discarded by main.cpp.
+    FlushPendingBatch();
     {
-        std::unique_lock<std::shared_mutex> lock(chunkMapMutex);
-        chunkMap.clear();
+        std::lock_guard<std::mutex> lock(evictMutex);
+        newlyEvicted.clear();
     }
-    SendUpdate();
+    std::lock_guard<std::mutex> lock(manifestMutex);
+    readyManifest.clear();
+    manifestReady = false;
 }
 
 void BlockESP::RemoveBlocks(const std::string& blockId) {
@@ -361,17 +408,144 @@ void BlockESP::RemoveBlocks(const std::string& blockId) {
         id = globalPaletteMap[blockId];
     }
 
-    std::unique_lock<std::shared_mutex> lock(chunkMapMutex);
-    for (auto& [key, chunk] : chunkMap) {
-        auto it = chunk.blocks.begin();
-        while (it != chunk.blocks.end()) {
-            if (it->second == id) {
-                it = chunk.blocks.erase(it);
-            } else {
-                ++it;
-            }
+    // The worker erases it from the indexed sections only and re-meshes those
+    PendingBatch().typeRemovals.push_back(id);
+}
+
+void BlockESP::ClearCache(bool resync) {
+    // Everything not yet handed over predates the clear, so it is dropped with the cache.
+    // Batches already in the ring are discarded by the worker when it sees clearFirst.
+    WorkerBatch& batch = PendingBatch();
+    batch.clearFirst = true;
+    batch.unloads.clear();
+    batch.updates.clear();
+    batch.sections.clear();
+    batch.restored.clear();
+    batch.typeRemovals.clear();
+    ResetEvictions(true);
+
+    // The mod still counts every column it sent as held here. The manifest of the emptied
+    // cache lists none, so it resends them all (a connect without identity does this anyway).
+    if (resync && net && net->IsConnected() && !awaitingIdentity) batch.sendManifest = true;
+}
+
+// cache/blockesp/<readable key>_<hash>.bin, one file per server/world/dimension
+static std::string WorldCachePath(const std::string& key) {
+    uint64_t hash = 14695981039346656037ULL; // FNV-1a
+    std::string name;
+    for (char c : key) {
+        hash = (hash ^ (uint8_t)c) * 1099511628211ULL;
+        name += (isalnum((unsigned char)c) || c == '.' || c == '-') ? c : '_';
+    }
+    if (name.size() > 64) name.resize(64);
+
+    char suffix[32];
+    snprintf(suffix, sizeof(suffix), "_%016llx.bin", (unsigned long long)hash);
+    return (fs::path("cache") / "blockesp" / (name + suffix)).string();
+}
+
+void BlockESP::SwitchWorld(const std::string& key) {
+    // Work not handed over yet belongs to the old world and would land in the new one
+    worldKey = key;
+    WorkerBatch& batch = PendingBatch();
+    batch.switchWorld = true;
+    batch.worldFile = key.empty() ? "" : WorldCachePath(key);
+    batch.clearFirst = false; // Implied by the switch
+    batch.unloads.clear();
+    batch.updates.clear();
+    batch.sections.clear();
+    batch.restored.clear();
+    batch.typeRemovals.clear();
+    ResetEvictions(false); // The mod starts the new world without evictions as well
+}
+
+// Evictions belong to the cache being dropped. With askBack the mod, which still holds the
+// columns as forgotten, is told to stream them again like any other column.
+void BlockESP::ResetEvictions(bool askBack) {
+    {
+        std::lock_guard<std::mutex> lock(evictMutex);
+        newlyEvicted.clear(); // Not announced yet: the mod still counts them as sent
+    }
+    if (askBack && !evictedColumns.empty() && net && net->IsConnected()) {
+        net->SendColumnList(0xE71C8, std::vector<std::pair<int, int>>(evictedColumns.begin(), evictedColumns.end()));
+    }
+    evictedColumns.clear();
+}
+
+WorkerBatch& BlockESP::PendingBatch() {
+    if (pendingBatch.Empty()) pendingBatch.queuedAt = std::chrono::steady_clock::now();
+    return pendingBatch;
+}
+
+void BlockESP::FlushPendingBatch() {
+    // Past this the worker is hopelessly behind; resetting is cheaper than holding the backlog
+    const size_t maxPendingUpdates = 1 << 20;
+
+    if (pendingBatch.Empty()) return;
+
+    if (!workerRing.TryPush(std::move(pendingBatch))) {
+        // Ring full: keep coalescing into pendingBatch and retry next frame
+        if (pendingBatch.updates.size() > maxPendingUpdates) {
+            droppedUpdates += pendingBatch.updates.size();
+            std::cout << "[BlockESP] Worker backlog over " << maxPendingUpdates << " updates, clearing cache" << std::endl;
+            ClearCache();
         }
+        return;
     }
+    pendingBatch = WorkerBatch();
+
+    // Lock/unlock pairs with the worker's predicate check so the wake-up can't be missed
+    { std::lock_guard<std::mutex> lock(queueMutex); }
+    queueCV.notify_one();
+}
+
+// Drops queued block data of columns being unloaded. An unload applies before the updates of
+// its batch, so data queued ahead of it has to go here or it would outlive the unload.
+static void DropUnloadedColumns(std::vector<BlockUpdate>& updates, std::vector<SectionBlocks>& sections,
+                                const std::vector<std::pair<int, int>>& unloads) {
+    if (unloads.empty() || (updates.empty() && sections.empty())) return;
+    std::set<std::pair<int, int>> columns(unloads.begin(), unloads.end());
+    updates.erase(std::remove_if(updates.begin(), updates.end(),
+        [&](const BlockUpdate& u) { return columns.count({ u.x >> 4, u.z >> 4 }) != 0; }), updates.end());
+    sections.erase(std::remove_if(sections.begin(), sections.end(),
+        [&](const SectionBlocks& s) { return columns.count({ s.cx, s.cz }) != 0; }), sections.end());
+}
+
+// Hands block data read from the mod to the worker (moved out, the lists are left empty).
+// The lists must already be in apply order: nothing in them precedes an unload of its column.
+void BlockESP::QueueBlockData(std::vector<BlockUpdate>& updates, std::vector<SectionBlocks>& sections, std::vector<std::pair<int, int>>& unloads) {
+    // Disabled types were dropped locally without telling the mod to confirm: blocks of them
+    // still in flight are discarded here rather than cached invisibly
+    auto isWanted = [&](const std::string& id) {
+        auto it = blocks.find(id);
+        return it != blocks.end() && it->second.enabled;
+    };
+    updates.erase(std::remove_if(updates.begin(), updates.end(),
+        [&](const BlockUpdate& u) { return !u.remove && !isWanted(u.id); }), updates.end());
+    for (auto& section : sections) {
+        uint16_t unwanted = 0; // Bit per palette slot
+        for (size_t i = 0; i < section.palette.size(); i++) {
+            if (!isWanted(section.palette[i])) unwanted |= 1 << i;
+        }
+        if (unwanted) {
+            section.entries.erase(std::remove_if(section.entries.begin(), section.entries.end(),
+                [&](uint16_t e) { return (unwanted >> (e >> 12)) & 1; }), section.entries.end());
+        }
+    }
+
+    if (unloads.empty() && updates.empty() && sections.empty()) return;
+    WorkerBatch& batch = PendingBatch();
+    DropUnloadedColumns(batch.updates, batch.sections, unloads);
+    batch.sections.insert(batch.sections.end(), std::make_move_iterator(sections.begin()), std::make_move_iterator(sections.end()));
+    sections.clear();
+    batch.unloads.insert(batch.unloads.end(), unloads.begin(), unloads.end());
+    unloads.clear();
+    if (batch.updates.empty()) {
+        batch.updates = std::move(updates);
+    } else {
+        batch.updates.insert(batch.updates.end(), std::make_move_iterator(updates.begin()), std::make_move_iterator(updates.end()));
+    }
+    updates.clear();
 }
 
 uint16_t BlockESP::GetBlockID(const std::string& name) {
@@ -394,54 +568,50 @@ std::string BlockESP::GetBlockName(uint16_t id) {
     return globalPalette[id - 1];
 }
 
-uint16_t BlockESP::GetBlock(int x, int y, int z) {
-    auto chunkPos = GetChunkPos(x, y, z);
-    
-    // NOTE: Caller must hold chunkMapMutex (Shared or Unique)
-    if (chunkMap.find(chunkPos) == chunkMap.end()) return 0;
-    
-    // Local coords (0-15)
-    int lx = x % 16; if (lx < 0) lx += 16;
-    int ly = y % 16; if (ly < 0) ly += 16;
-    int lz = z % 16; if (lz < 0) lz += 16;
-    
-    int index = lx + (ly * 16) + (lz * 256);
-    
-    const auto& chunk = chunkMap.at(chunkPos);
-    
-    // Protect block access
-    std::lock_guard<std::mutex> lock(chunk.blockMutex);
-    const auto& blocks = chunk.blocks;
-    
-    auto it = blocks.find(index);
-    if (it != blocks.end()) {
-        return it->second;
+static PaletteColor MakePaletteColor(const BlockConfig& conf) {
+    PaletteColor pc;
+    pc.visible = conf.enabled;
+    pc.edge = IM_COL32(conf.color[0]*255, conf.color[1]*255, conf.color[2]*255, 255);
+    pc.face = IM_COL32(conf.color[0]*255, conf.color[1]*255, conf.color[2]*255, 50);
+    return pc;
+}
+
+void BlockESP::RefreshPaletteColors() {
+    // Main thread only. Fills entries for palette IDs added by the worker since the
+    // last call, or the whole table after a config load.
+    std::lock_guard<std::mutex> lock(paletteMutex);
+    size_t size = globalPalette.size() + 1;
+    size_t first = paletteColorsDirty ? 1 : paletteColors.size();
+    if (first >= size) return;
+
+    paletteColors.resize(size);
+    for (size_t id = first; id < size; id++) {
+        auto it = blocks.find(globalPalette[id - 1]);
+        paletteColors[id] = (it != blocks.end()) ? MakePaletteColor(it->second) : PaletteColor{};
     }
-    return 0;
+    paletteColorsDirty = false;
 }
 
-void BlockESP::RebuildAllChunks() {
-    // This is called from GUI thread (RenderSettings) when toggling/coloring.
-    // It should trigger rebuilds.
-    // Since we are now async, we should probably just mark all chunks dirty or push a special update?
-    // But RebuildAllChunks was synchronous.
-    // Let's make it trigger async rebuild by pushing an empty update? No.
-    // We can just iterate and call UpdateChunk, but UpdateChunk is now thread-safe (mostly).
-    // However, UpdateChunk builds mesh.
-    // If we call it here, we block the GUI.
-    // Better: Iterate all keys and add them to a "Force Rebuild" list?
-    // Or just run it synchronously here? It might freeze the UI for a moment.
-    // Given the user wants smoothness, we should probably offload this too.
-    // But for now, to keep it simple and safe, let's just lock and run it (as it was before, essentially).
-    
-    std::shared_lock<std::shared_mutex> lock(chunkMapMutex);
-    for (auto& [key, chunk] : chunkMap) {
-        UpdateChunk(key);
+void BlockESP::UpdatePaletteColor(const std::string& blockId) {
+    uint16_t id = 0;
+    {
+        std::lock_guard<std::mutex> lock(paletteMutex);
+        auto it = globalPaletteMap.find(blockId);
+        if (it == globalPaletteMap.end()) return; // No mesh references it yet
+        id = it->second;
+    }
+    // Entries past the end are filled from the config on the next refresh
+    if (id < paletteColors.size()) {
+        paletteColors[id] = MakePaletteColor(blocks[blockId]);
     }
 }
 
 void BlockESP::SendUpdate() {
     if (!net) return;
+
+    // The full list supersedes any toggles not sent yet
+    pendingTypeAdds.clear();
+    pendingTypeRemoves.clear();
     
     std::vector<std::string> enabledBlocks;
     if (enabled) {
@@ -455,9 +625,65 @@ void BlockESP::SendUpdate() {
     net->SendBlockList(enabledBlocks);
 }
 
+// Hands the worker's evictions to the mod (forget them), and twice a second asks back the
+// evicted columns the camera is in range of again
+void BlockESP::UpdateEvictions(const GameData& data) {
+    std::vector<std::pair<int, int>> evicted;
+    {
+        std::lock_guard<std::mutex> lock(evictMutex);
+        evicted.swap(newlyEvicted);
+    }
+    if (!evicted.empty()) {
+        net->SendColumnList(0xE71C7, evicted);
+        evictedColumns.insert(evicted.begin(), evicted.end());
+    }
+
+    long long nowMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    if (evictedColumns.empty() || nowMs - lastRestoreCheck < 500) return;
+    lastRestoreCheck = nowMs;
+
+    int camCx = (int)std::floor(data.camX / 16.0);
+    int camCz = (int)std::floor(data.camZ / 16.0);
+    // Asked back a few columns inside the eviction radius, so a camera pacing across that
+    // radius doesn't evict and re-stream the same columns over and over
+    long long restore = (std::max)(keepRange.load(std::memory_order_relaxed) / 16 + 1 - kRestoreMargin, 1LL);
+    std::vector<std::pair<int, int>> restored;
+    for (auto it = evictedColumns.begin(); it != evictedColumns.end();) {
+        long long dx = it->first - camCx, dz = it->second - camCz;
+        if (dx * dx + dz * dz <= restore * restore) {
+            restored.push_back(*it);
+            it = evictedColumns.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    if (restored.empty()) return;
+
+    // The worker accepts their data again before the mod's answer can arrive
+    WorkerBatch& batch = PendingBatch();
+    batch.restored.insert(batch.restored.end(), restored.begin(), restored.end());
+    net->SendColumnList(0xE71C8, restored);
+}
+
+void BlockESP::FlushTypeChanges() {
+    if (!net || (pendingTypeAdds.empty() && pendingTypeRemoves.empty())) return;
+    long long nowMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    if (nowMs - lastTypeToggle < 250) return; // Still clicking
+
+    std::vector<std::string> added(pendingTypeAdds.begin(), pendingTypeAdds.end());
+    std::vector<std::string> removed(pendingTypeRemoves.begin(), pendingTypeRemoves.end());
+    if (!net->SendBlockListDiff(added, removed)) return;
+    pendingTypeAdds.clear();
+    pendingTypeRemoves.clear();
+}
+
 void BlockESP::SaveConfig(std::ostream& stream) {
     Module::SaveConfig(stream);
     stream << "RenderRange=" << renderRange << "\n";
+    stream << "FrameBudget=" << frameBudgetMs << "\n";
+    stream << "AdaptiveRange=" << (adaptiveRange ? 1 : 0) << "\n";
+    stream << "QuadSeams=" << (quadSeams ? 1 : 0) << "\n";
+    stream << "MemoryBudget=" << memoryBudgetMB << "\n";
     for (const auto& pair : blocks) {
         // Save if enabled OR if color has been initialized/customized
         if (pair.second.enabled || pair.second.colorInitialized) {
@@ -476,6 +702,20 @@ void BlockESP::LoadConfig(const std::map<std::string, std::string>& config) {
     if (config.count("RenderRange")) {
         renderRange = std::stoi(config.at("RenderRange"));
     }
+    if (config.count("FrameBudget")) {
+        frameBudgetMs = std::stof(config.at("FrameBudget"));
+    }
+    if (config.count("AdaptiveRange")) {
+        adaptiveRange = config.at("AdaptiveRange") == "1";
+    }
+    if (config.count("QuadSeams")) {
+        bool seams = config.at("QuadSeams") == "1";
+        if (seams != quadSeams.exchange(seams)) PendingBatch().remeshAll = true;
+    }
+    if (config.count("MemoryBudget")) {
+        memoryBudgetMB = std::stoi(config.at("MemoryBudget"));
+    }
+    effectiveRange = (float)renderRange;
 
     for (const auto& pair : config) {
         if (pair.first.rfind("Block_", 0) == 0) { // Starts with "Block_"
@@ -506,11 +746,10 @@ void BlockESP::LoadConfig(const std::map<std::string, std::string>& config) {
             }
         }
     }
+    paletteColorsDirty = true;
+
     // Update server after loading
-    {
-        std::unique_lock<std::shared_mutex> lock(chunkMapMutex);
-        chunkMap.clear();
-    }
+    ClearCache();
     SendUpdate();
 }
 
@@ -523,14 +762,48 @@ std::tuple<int, int, int> BlockESP::GetChunkPos(int x, int y, int z) {
     return {cx, cy, cz};
 }
 
-void BlockESP::ProcessUpdates(const std::vector<BlockUpdate>& updates, long long& outUpdateTime, long long& outRebuildTime) {
+void BlockESP::ProcessTypeRemovals(const std::vector<uint16_t>& ids) {
+    // Only sections that contain the type change: neighbours without it neither
+    // cull against it nor draw it.
+    SectionSet dirtyChunks;
+
+    std::shared_lock<std::shared_mutex> lock(chunkMapMutex);
+    for (uint16_t id : ids) {
+        if (id >= typeSections.size()) continue;
+
+        for (const auto& chunkPos : typeSections[id]) {
+            auto it = chunkMap.find(chunkPos);
+            if (it == chunkMap.end()) continue;
+
+            std::lock_guard<std::mutex> blockLock(it->second.blockMutex);
+            auto& blocks = it->second.blocks;
+            for (auto b = blocks.begin(); b != blocks.end(); ) {
+                if (b->second == id) {
+                    b = blocks.erase(b);
+                } else {
+                    ++b;
+                }
+            }
+            dirtyChunks.insert(chunkPos);
+        }
+        typeSections[id].clear();
+    }
+
+    for (const auto& chunkPos : dirtyChunks) {
+        UpdateChunk(chunkPos);
+    }
+}
+
+void BlockESP::ProcessUpdates(const std::vector<BlockUpdate>& updates, const std::vector<SectionBlocks>& sections, long long& outUpdateTime, long long& outRebuildTime, int& outRebuildCount) {
     outUpdateTime = 0;
     outRebuildTime = 0;
-    if (updates.empty()) return;
+    outRebuildCount = 0;
+    if (updates.empty() && sections.empty()) return;
 
     auto startUpdate = std::chrono::high_resolution_clock::now();
 
-    std::set<std::tuple<int, int, int>> dirtyChunks;
+    SectionSet dirtyChunks;
+    dirtyChunks.reserve(updates.size() / 4 + 16);
 
     // Phase 1: Update Blocks
     // Optimization: Avoid holding Unique Lock for the entire duration.
@@ -538,12 +811,15 @@ void BlockESP::ProcessUpdates(const std::vector<BlockUpdate>& updates, long long
     // Use Shared Lock + Per-Chunk Lock when UPDATING blocks.
     
     // 1. Identify chunks that need to be created
-    std::set<std::tuple<int, int, int>> neededChunks;
+    SectionSet neededChunks;
     for (const auto& u : updates) {
         if (!u.remove) { // We only create chunks if we are adding blocks
             neededChunks.insert(GetChunkPos(u.x, u.y, u.z));
         }
     }
+    for (const auto& s : sections) {
+        if (!s.entries.empty()) neededChunks.insert({ s.cx, s.cy, s.cz });
+    }
 
     {
         // Check for missing chunks with Shared Lock first
@@ -569,6 +845,50 @@ void BlockESP::ProcessUpdates(const std::vector<BlockUpdate>& updates, long long
     // 2. Update Blocks (Shared Lock on Map, Unique Lock on Chunk)
     {
         std::shared_lock<std::shared_mutex> lock(chunkMapMutex);
+
+        // Bulk sections first (scans; the per-block diffs are live edits made after them).
+        // Ids resolve once per packet and the sorted indices make every map insert hinted.
+        for (const auto& s : sections) {
+            std::tuple<int, int, int> chunkPos{ s.cx, s.cy, s.cz };
+            auto it = chunkMap.find(chunkPos);
+            if (it == chunkMap.end()) continue;
+            auto& chunk = it->second;
+
+            uint16_t ids[16];
+            for (size_t i = 0; i < s.palette.size(); i++) {
+                ids[i] = GetBlockID(s.palette[i]);
+                if (ids[i] >= typeSections.size()) typeSections.resize(ids[i] + 1);
+                typeSections[ids[i]].insert(chunkPos);
+            }
+
+            // Sections to re-mesh, one bit per offset (ox + 1) * 9 + (oy + 1) * 3 + (oz + 1)
+            auto neighbourBit = [](int ox, int oy, int oz) { return 1u << ((ox + 1) * 9 + (oy + 1) * 3 + (oz + 1)); };
+            uint32_t neighbours = 0;
+            {
+                std::lock_guard<std::mutex> blockLock(chunk.blockMutex);
+                auto hint = chunk.blocks.begin();
+                for (uint16_t e : s.entries) {
+                    size_t slot = e >> 12;
+                    int index = e & 0xFFF;
+                    if (slot >= s.palette.size()) continue;
+                    hint = std::next(chunk.blocks.insert_or_assign(hint, index, ids[slot]));
+
+                    int lx = index & 15, ly = (index >> 4) & 15, lz = index >> 8;
+                    int ox = (lx == 0) ? -1 : (lx == 15 ? 1 : 0);
+                    int oy = (ly == 0) ? -1 : (ly == 15 ? 1 : 0);
+                    int oz = (lz == 0) ? -1 : (lz == 15 ? 1 : 0);
+                    if (!ox && !oy && !oz) continue;
+                    // Same faces and edges as the per-block path; zero offsets land on bit 13
+                    neighbours |= neighbourBit(ox, 0, 0) | neighbourBit(0, oy, 0) | neighbourBit(0, 0, oz);
+                    neighbours |= neighbourBit(ox, oy, 0) | neighbourBit(ox, 0, oz) | neighbourBit(0, oy, oz);
+                }
+            }
+
+            neighbours |= neighbourBit(0, 0, 0);
+            for (int bit = 0; bit < 27; bit++) {
+                if (neighbours & (1u << bit)) dirtyChunks.insert({ s.cx + bit / 9 - 1, s.cy + (bit / 3) % 3 - 1, s.cz + bit % 3 - 1 });
+            }
+        }
         
         for (const auto& u : updates) {
             auto chunkPos = GetChunkPos(u.x, u.y, u.z);
@@ -589,19 +909,27 @@ void BlockESP::ProcessUpdates(const std::vector<BlockUpdate>& updates, long long
                 chunk.blocks.erase(index);
                 // We do NOT erase empty chunks here to avoid upgrading lock
             } else {
-                chunk.blocks[index] = GetBlockID(u.id);
+                uint16_t id = GetBlockID(u.id);
+                chunk.blocks[index] = id;
+                if (id >= typeSections.size()) typeSections.resize(id + 1);
+                typeSections[id].insert(chunkPos);
             }
 
             // Mark dirty
             dirtyChunks.insert(chunkPos);
 
-            // Neighbors
-            int neighbors[6][3] = {
-                {1,0,0}, {-1,0,0}, {0,1,0}, {0,-1,0}, {0,0,1}, {0,0,-1}
-            };
-            for(int i=0; i<6; i++) {
-                 dirtyChunks.insert(GetChunkPos(u.x + neighbors[i][0], u.y + neighbors[i][1], u.z + neighbors[i][2]));
-            }
+            // Neighbors: only a block on a section face can change the face neighbour's mesh,
+            // one on a section edge also the edge neighbour's (both read it as padding)
+            int cx = std::get<0>(chunkPos), cy = std::get<1>(chunkPos), cz = std::get<2>(chunkPos);
+            int ox = (lx == 0) ? -1 : (lx == 15 ? 1 : 0);
+            int oy = (ly == 0) ? -1 : (ly == 15 ? 1 : 0);
+            int oz = (lz == 0) ? -1 : (lz == 15 ? 1 : 0);
+            if (ox) dirtyChunks.insert({cx + ox, cy, cz});
+            if (oy) dirtyChunks.insert({cx, cy + oy, cz});
+            if (oz) dirtyChunks.insert({cx, cy, cz + oz});
+            if (ox && oy) dirtyChunks.insert({cx + ox, cy + oy, cz});
+            if (ox && oz) dirtyChunks.insert({cx + ox, cy, cz + oz});
+            if (oy && oz) dirtyChunks.insert({cx, cy + oy, cz + oz});
         }
     }
 
@@ -616,6 +944,7 @@ void BlockESP::ProcessUpdates(const std::vector<BlockUpdate>& updates, long long
             // Check if chunk still exists (it might have been removed if empty)
             if (chunkMap.count(chunkPos)) {
                 UpdateChunk(chunkPos);
+                outRebuildCount++;
             }
         }
     }
@@ -624,35 +953,52 @@ void BlockESP::ProcessUpdates(const std::vector<BlockUpdate>& updates, long long
     outRebuildTime = std::chrono::duration_cast<std::chrono::microseconds>(endRebuild - startRebuild).count();
 }
 
-// Helper struct for edge merging
-struct TempEdge {
-    float x1, y1, z1;
-    float x2, y2, z2;
-    ImU32 color;
-    int axis; // 0=X, 1=Y, 2=Z
-    
-    bool operator<(const TempEdge& other) const {
-        if (color != other.color) return color < other.color;
-        if (axis != other.axis) return axis < other.axis;
-        
-        // Primary sort key: Constant coordinates
-        // Secondary sort key: Variable coordinate start
-        if (axis == 0) { // X is variable. Y, Z constant
-             if (y1 != other.y1) return y1 < other.y1;
-             if (z1 != other.z1) return z1 < other.z1;
-             return x1 < other.x1;
-        } else if (axis == 1) { // Y is variable. X, Z constant
-             if (x1 != other.x1) return x1 < other.x1;
-             if (z1 != other.z1) return z1 < other.z1;
-             return y1 < other.y1;
-        } else { // Z is variable. X, Y constant
-             if (x1 != other.x1) return x1 < other.x1;
-             if (y1 != other.y1) return y1 < other.y1;
-             return z1 < other.z1;
-        }
-    }
+// Heap one insert leaves allocated, per MemTrack. Measured once, not assumed from a particular
+// standard library's node layout.
+template <typename Insert>
+static size_t HeldBytes(Insert insert) {
+    int64_t before = MemTrack::ThreadNetBytes();
+    insert();
+    return (size_t)(std::max)(MemTrack::ThreadNetBytes() - before, (int64_t)0);
+}
+
+struct SectionHeapSizes {
+    size_t sectionNode; // chunkMap entry
+    size_t blockNode;   // CachedChunk::blocks entry
+    size_t typeNode;    // typeSections entry
+    size_t meshBlock;   // make_shared<ChunkMesh>: control block and mesh in one allocation
 };
 
+static const SectionHeapSizes& MeasuredSectionSizes() {
+    static const SectionHeapSizes sizes = [] {
+        SectionHeapSizes measured;
+        // Second inserts, so a container's first-use allocations (sentinel, buckets) don't count
+        std::map<std::tuple<int, int, int>, CachedChunk> sections;
+        sections[{ 0, 0, 0 }];
+        measured.sectionNode = HeldBytes([&] { sections[{ 1, 0, 0 }].mesh.reset(); }); // Node only
+        std::map<int, uint16_t> blocks;
+        blocks[0] = 1;
+        measured.blockNode = HeldBytes([&] { blocks[1] = 1; });
+        SectionSet types;
+        types.insert({ 0, 0, 0 });
+        measured.typeNode = HeldBytes([&] { types.insert({ 1, 0, 0 }); });
+        std::shared_ptr<ChunkMesh> mesh;
+        measured.meshBlock = HeldBytes([&] { mesh = std::make_shared<ChunkMesh>(); });
+        return measured;
+    }();
+    return sizes;
+}
+
+// Heap held by one cached section: its chunkMap node, a node per block, a typeSections entry
+// per type and the mesh. The mesh vectors hold exactly capacity * element size.
+static size_t SectionBytes(size_t blockCount, size_t typeCount, const ChunkMesh& mesh) {
+    const SectionHeapSizes& heap = MeasuredSectionSizes();
+    size_t bytes = heap.sectionNode + blockCount * heap.blockNode + typeCount * heap.typeNode + heap.meshBlock;
+    bytes += mesh.edges.capacity() * sizeof(PackedEdge) + mesh.faces.capacity() * sizeof(PackedFace);
+    bytes += mesh.boxes.capacity() * sizeof(PackedBox) + mesh.dots.capacity() * sizeof(PackedDot);
+    return bytes;
+}
+
 void BlockESP::UpdateChunk(std::tuple<int, int, int> chunkPos) {
     // NOTE: Caller holds chunkMapMutex (Shared or Unique)
     
@@ -662,9 +1008,11 @@ void BlockESP::UpdateChunk(std::tuple<int, int, int> chunkPos) {
     // So we are safe.
     
     const auto& chunk = chunkMap.at(chunkPos);
+    meshChanged.insert(chunkPos);
     
-    // Create NEW mesh
+    // Create NEW mesh (a rebuild doesn't make the section any more recently seen)
     auto newMesh = std::make_shared<ChunkMesh>();
+    if (chunk.mesh) newMesh->lastVisibleMs.store(chunk.mesh->lastVisibleMs.load(std::memory_order_relaxed), std::memory_order_relaxed);
     
     // Bounds
     int cx = std::get<0>(chunkPos);
@@ -675,545 +1023,1637 @@ void BlockESP::UpdateChunk(std::tuple<int, int, int> chunkPos) {
     int startY = cy * 16;
     int startZ = cz * 16;
 
-    // 1. Build Lookup Table for Block Properties
-    struct BlockInfo {
-        bool enabled;
-        ImU32 color;
-        ImU32 faceColor;
-    };
-    
-    // We can't easily index by ID since IDs are dynamic, but globalPalette is a vector.
-    // ID corresponds to globalPalette index + 1.
-    // Accessing globalPalette requires lock? 
-    // globalPalette is modified in GetBlockID (Phase 1).
-    // UpdateChunk runs in Phase 2.
-    // Phase 1 and Phase 2 are sequential in Worker thread.
-    // But RenderSettings (Main Thread) might modify globalPalette?
-    // No, RenderSettings reads availableBlocks, doesn't add to globalPalette.
-    // Only GetBlockID adds to globalPalette.
-    // So globalPalette is stable during Phase 2?
-    // Unless GetBlockID is called from another thread? No.
-    // Wait, RenderSettings might call RebuildAllChunks -> UpdateChunk -> globalPalette access.
-    // So we need locking.
-    
-    std::vector<BlockInfo> blockInfos;
+    // 1. Palette Size
+    // Meshes store palette IDs; colours and visibility are resolved at draw time
+    // (see RefreshPaletteColors), so meshing never reads the block config.
+    size_t paletteSize;
     {
         std::lock_guard<std::mutex> lock(paletteMutex);
-        blockInfos.resize(globalPalette.size() + 1);
-        for (size_t i = 0; i < globalPalette.size(); i++) {
-            std::string name = globalPalette[i];
-            if (blocks.count(name)) {
-                const auto& conf = blocks[name];
-                blockInfos[i + 1].enabled = conf.enabled;
-                if (conf.enabled) {
-                    blockInfos[i + 1].color = IM_COL32(conf.color[0]*255, conf.color[1]*255, conf.color[2]*255, 255);
-                    blockInfos[i + 1].faceColor = IM_COL32(conf.color[0]*255, conf.color[1]*255, conf.color[2]*255, 50);
-                }
-            } else {
-                blockInfos[i + 1].enabled = false;
+        paletteSize = globalPalette.size() + 1;
+    }
+
+    // 2. Build Bit-Parallel Occupancy (one set of row masks per block type)
+    // Rows carry one voxel of padding on the two non-row axes, taken from the neighbour
+    // sections, so faces and outline edges on the section border need no map lookups.
+    // Padded index = local coordinate + 1 (0 = previous section, 17 = next section).
+    struct TypeOccupancy {
+        uint16_t id;
+        uint16_t rowX[18][18]; // [y+1][z+1], bit = x
+        uint16_t rowY[18][18]; // [x+1][z+1], bit = y
+        uint16_t rowZ[18][18]; // [x+1][y+1], bit = z
+    };
+
+    std::vector<TypeOccupancy> types;
+    std::vector<int> slotOf(paletteSize, -1);
+
+    // Sets the voxel at section-relative (x, y, z), each in [-1, 16], in every row that can hold it
+    auto setVoxel = [](TypeOccupancy& t, int x, int y, int z) {
+        if (x >= 0 && x < 16) t.rowX[y + 1][z + 1] |= (uint16_t)(1u << x);
+        if (y >= 0 && y < 16) t.rowY[x + 1][z + 1] |= (uint16_t)(1u << y);
+        if (z >= 0 && z < 16) t.rowZ[x + 1][y + 1] |= (uint16_t)(1u << z);
+    };
+
+    {
+        std::lock_guard<std::mutex> blockLock(chunk.blockMutex);
+        for (const auto& [index, id] : chunk.blocks) {
+            if (id == 0 || id >= slotOf.size()) continue;
+            if (slotOf[id] < 0) {
+                slotOf[id] = (int)types.size();
+                types.emplace_back();
+                std::memset(&types.back(), 0, sizeof(TypeOccupancy));
+                types.back().id = id;
             }
+            setVoxel(types[slotOf[id]], index % 16, (index / 16) % 16, index / 256);
         }
     }
 
-    // 2. Fill Dense Chunk Data
-    // 0 = Air or Disabled Block. >0 = ID of Enabled Block.
-    uint16_t data[16][16][16];
-    std::memset(data, 0, sizeof(data));
+    if (types.empty()) {
+        // Nothing to draw, publish an empty mesh
+        const_cast<CachedChunk&>(chunk).mesh = newMesh;
+        const_cast<CachedChunk&>(chunk).bytes = SectionBytes(chunk.blocks.size(), 0, *newMesh);
+        return;
+    }
 
-    for (const auto& [index, id] : chunk.blocks) {
-        if (id < blockInfos.size() && blockInfos[id].enabled) {
-            int lx = index % 16;
-            int ly = (index / 16) % 16;
-            int lz = index / 256;
-            data[lx][ly][lz] = id;
+    // Padding: the 6 face and 12 edge neighbours (corner sections never touch a padded row).
+    // One map lookup per neighbour section instead of one per boundary voxel.
+    for (int ox = -1; ox <= 1; ox++) {
+        for (int oy = -1; oy <= 1; oy++) {
+            for (int oz = -1; oz <= 1; oz++) {
+                int axes = (ox != 0) + (oy != 0) + (oz != 0);
+                if (axes == 0 || axes == 3) continue;
+
+                auto it = chunkMap.find({cx + ox, cy + oy, cz + oz});
+                if (it == chunkMap.end()) continue;
+
+                std::lock_guard<std::mutex> blockLock(it->second.blockMutex);
+                for (const auto& [index, id] : it->second.blocks) {
+                    if (id >= slotOf.size() || slotOf[id] < 0) continue; // Only types present here matter
+                    int x = index % 16 + ox * 16;
+                    int y = (index / 16) % 16 + oy * 16;
+                    int z = index / 256 + oz * 16;
+                    if (x < -1 || x > 16 || y < -1 || y > 16 || z < -1 || z > 16) continue;
+                    setVoxel(types[slotOf[id]], x, y, z);
+                }
+            }
         }
     }
 
+    newMesh->originX = startX;
+    newMesh->originY = startY;
+    newMesh->originZ = startZ;
+
     // 3. Greedy Meshing
     // Directions: 0: -Z (North), 1: +X (East), 2: +Z (South), 3: -X (West), 4: +Y (Up), 5: -Y (Down)
-    static const int faceDirs[6][3] = {
-        {0, 0, -1}, {1, 0, 0}, {0, 0, 1}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}
-    };
-    
-    std::vector<TempEdge> tempEdges;
-
-    for (int dir = 0; dir < 6; dir++) {
-        // Determine U, V axes
-        int uAxis, vAxis, dAxis;
-        if (dir == 0 || dir == 2) { // Z faces
-            dAxis = 2; uAxis = 0; vAxis = 1; // Depth=Z, U=X, V=Y
-        } else if (dir == 1 || dir == 3) { // X faces
-            dAxis = 0; uAxis = 2; vAxis = 1; // Depth=X, U=Z, V=Y
-        } else { // Y faces
-            dAxis = 1; uAxis = 0; vAxis = 2; // Depth=Y, U=X, V=Z
+    // Layer masks use the same (u, v) convention as before:
+    // Z-faces (d=z): u=x, v=y | X-faces (d=x): u=z, v=y | Y-faces (d=y): u=x, v=z
+    // With quad seams on, every quad's outline is also recorded per type as lattice-line
+    // bitmasks ([axis][p][q], laid out like the rows of step 4) and merged into the edges there.
+    struct QuadLines { uint16_t line[3][17][17]; };
+    std::vector<QuadLines> quadLines(quadSeams.load(std::memory_order_relaxed) ? types.size() : 0, QuadLines{});
+    QuadLines* lines = nullptr;
+
+    auto emitQuad = [&](int dir, int d, int u, int v, int w, int h, uint16_t id) {
+        // Min corner of the quad, local to chunk
+        int x1, y1, z1;
+        if (dir == 0 || dir == 2) { // Z faces: u=x, v=y, d=z
+            x1 = u; y1 = v; z1 = (dir == 2) ? d + 1 : d;
+        } else if (dir == 1 || dir == 3) { // X faces: u=z, v=y, d=x
+            x1 = (dir == 1) ? d + 1 : d; y1 = v; z1 = u;
+        } else { // Y faces: u=x, v=z, d=y
+            x1 = u; y1 = (dir == 4) ? d + 1 : d; z1 = v;
+        }
+        newMesh->faces.push_back(PackFace(x1, y1, z1, w, h, dir, id));
+
+        if (lines) {
+            uint16_t runU = (uint16_t)(((1u << w) - 1u) << u);
+            uint16_t runV = (uint16_t)(((1u << h) - 1u) << v);
+            if (dir == 0 || dir == 2) {        // Along X at y = v, v+h; along Y at x = u, u+w
+                lines->line[0][v][z1] |= runU; lines->line[0][v + h][z1] |= runU;
+                lines->line[1][u][z1] |= runV; lines->line[1][u + w][z1] |= runV;
+            } else if (dir == 1 || dir == 3) { // Along Z at y = v, v+h; along Y at z = u, u+w
+                lines->line[2][x1][v] |= runU; lines->line[2][x1][v + h] |= runU;
+                lines->line[1][x1][u] |= runV; lines->line[1][x1][u + w] |= runV;
+            } else {                           // Along X at z = v, v+h; along Z at x = u, u+w
+                lines->line[0][y1][v] |= runU; lines->line[0][y1][v + h] |= runU;
+                lines->line[2][u][y1] |= runV; lines->line[2][u + w][y1] |= runV;
+            }
         }
+    };
 
-        // Iterate through layers of Depth Axis
+    for (const auto& t : types) {
+        lines = quadLines.empty() ? nullptr : &quadLines[&t - types.data()];
         for (int d = 0; d < 16; d++) {
-            uint16_t mask[16][16] = {0}; // mask[v][u]
-
-            // Fill mask
-            for (int v = 0; v < 16; v++) {
-                for (int u = 0; u < 16; u++) {
-                    // Map u, v, d to lx, ly, lz
-                    int lx, ly, lz;
-                    if (dAxis == 0) { lx = d; ly = v; lz = u; } // X=d, Y=v, Z=u (Wait, mapping depends on axis choice above)
-                    // Let's use standard mapping:
-                    // Z-faces (d=z): u=x, v=y
-                    // X-faces (d=x): u=z, v=y
-                    // Y-faces (d=y): u=x, v=z
-                    
-                    if (dir == 0 || dir == 2) { lx = u; ly = v; lz = d; }
-                    else if (dir == 1 || dir == 3) { lx = d; ly = v; lz = u; }
-                    else { lx = u; ly = d; lz = v; }
-
-                    uint16_t id = data[lx][ly][lz];
-                    if (id == 0) continue;
-
-                    // Check neighbor in direction 'dir'
-                    int nx = lx + faceDirs[dir][0];
-                    int ny = ly + faceDirs[dir][1];
-                    int nz = lz + faceDirs[dir][2];
-
-                    uint16_t neighborId = 0;
-                    if (nx >= 0 && nx < 16 && ny >= 0 && ny < 16 && nz >= 0 && nz < 16) {
-                        neighborId = data[nx][ny][nz];
-                    } else {
-                        // Global lookup (Requires lock, which we hold)
-                        neighborId = GetBlock(startX + nx, startY + ny, startZ + nz);
-                        // Filter neighborId: if it's not enabled, treat as air (0) so we draw face
-                        if (neighborId >= blockInfos.size() || !blockInfos[neighborId].enabled) {
-                            neighborId = 0;
+            // Visible faces of this layer: occupied AND-NOT occupied in the facing row
+            uint16_t layers[6][16];
+            for (int r = 0; r < 16; r++) {
+                // Z faces (v=y): rowX[y][z]
+                uint16_t curZ = t.rowX[r + 1][d + 1];
+                layers[0][r] = curZ & ~t.rowX[r + 1][d];
+                layers[2][r] = curZ & ~t.rowX[r + 1][d + 2];
+                // Y faces (v=z): rowX[y][z]
+                uint16_t curY = t.rowX[d + 1][r + 1];
+                layers[5][r] = curY & ~t.rowX[d][r + 1];
+                layers[4][r] = curY & ~t.rowX[d + 2][r + 1];
+                // X faces (v=y): rowZ[x][y]
+                uint16_t curX = t.rowZ[d + 1][r + 1];
+                layers[3][r] = curX & ~t.rowZ[d][r + 1];
+                layers[1][r] = curX & ~t.rowZ[d + 2][r + 1];
+            }
+
+            // Greedy Mesh the layer: take the lowest run of a row, then grow it down
+            // while the following rows contain the whole run
+            for (int dir = 0; dir < 6; dir++) {
+                uint16_t* rows = layers[dir];
+                for (int v = 0; v < 16; v++) {
+                    while (rows[v]) {
+                        uint32_t row = rows[v];
+                        int u = Ctz32(row);
+                        int w = Ctz32(~(row >> u));
+                        uint16_t run = (uint16_t)(((1u << w) - 1u) << u);
+
+                        int h = 1;
+                        while (v + h < 16 && (rows[v + h] & run) == run) {
+                            rows[v + h] &= (uint16_t)~run;
+                            h++;
                         }
-                    }
+                        rows[v] &= (uint16_t)~run;
 
-                    if (neighborId != id) {
-                        mask[v][u] = id;
+                        emitQuad(dir, d, u, v, w, h, t.id);
                     }
                 }
             }
+        }
+    }
 
-            // Greedy Mesh the mask
-            bool visited[16][16] = {false};
-            for (int v = 0; v < 16; v++) {
-                for (int u = 0; u < 16; u++) {
-                    if (visited[v][u] || mask[v][u] == 0) continue;
-
-                    uint16_t id = mask[v][u];
-                    
-                    // Compute width (along U)
-                    int w = 1;
-                    while (u + w < 16 && !visited[v][u + w] && mask[v][u + w] == id) {
-                        w++;
+    // 4. Outline Edges
+    // A unit lattice edge is part of the outline when the four voxels around it are not
+    // a flat surface: exactly one or three filled (odd parity), or two filled diagonally.
+    // Edges along an axis come out of the rows of that axis as bitmasks, so collinear
+    // segments are merged by taking runs of set bits - no sort or merge pass.
+    // A seam edge on the section border is seen by every section around it; only the one
+    // holding the first filled voxel of (p, q), (p, q-1), (p-1, q), (p-1, q-1) emits it,
+    // so neighbours never draw the same segment twice. Quad seams follow the same ownership:
+    // a surface crossing the border ends a quad on both sides of it.
+    for (const auto& t : types) {
+        const QuadLines* seams = quadLines.empty() ? nullptr : &quadLines[&t - types.data()];
+        for (int axis = 0; axis < 3; axis++) {
+            const uint16_t (*rows)[18] = (axis == 0) ? t.rowX : ((axis == 1) ? t.rowY : t.rowZ);
+
+            // Lattice lines (p, q) in [0, 16]; voxels at p-1/p and q-1/q are padded rows p/p+1, q/q+1
+            for (int p = 0; p <= 16; p++) {
+                for (int q = 0; q <= 16; q++) {
+                    uint16_t a = rows[p][q];         // (p-1, q-1)
+                    uint16_t b = rows[p][q + 1];     // (p-1, q)
+                    uint16_t c = rows[p + 1][q];     // (p,   q-1)
+                    uint16_t dd = rows[p + 1][q + 1]; // (p,   q)
+
+                    uint16_t own = 0;
+                    if (p < 16 && q < 16) own |= dd;
+                    if (p < 16 && q > 0)  own |= c & ~dd;
+                    if (p > 0 && q < 16)  own |= b & ~dd & ~c;
+                    if (p > 0 && q > 0)   own |= a & ~dd & ~c & ~b;
+                    if (!own) continue;
+
+                    uint16_t odd = a ^ b ^ c ^ dd;
+                    uint16_t diag = (a & dd & ~b & ~c) | (b & c & ~a & ~dd);
+                    uint16_t lineBits = odd | diag;
+                    if (seams) lineBits |= seams->line[axis][p][q];
+                    uint32_t bits = (uint16_t)(lineBits & own);
+
+                    while (bits) {
+                        int s = Ctz32(bits);
+                        int len = Ctz32(~(bits >> s));
+                        bits &= ~(((1u << len) - 1u) << s);
+
+                        // Rows are X: [y][z], Y: [x][z], Z: [x][y]
+                        if (axis == 0)      newMesh->edges.push_back(PackEdge(s, p, q, len, 0, t.id));
+                        else if (axis == 1) newMesh->edges.push_back(PackEdge(p, s, q, len, 1, t.id));
+                        else                newMesh->edges.push_back(PackEdge(p, q, s, len, 2, t.id));
                     }
+                }
+            }
+        }
+    }
 
-                    // Compute height (along V)
-                    int h = 1;
-                    bool canExtend = true;
-                    while (v + h < 16) {
-                        for (int k = 0; k < w; k++) {
-                            if (visited[v + h][u + k] || mask[v + h][u + k] != id) {
-                                canExtend = false;
-                                break;
+    // 5. LOD: vein boxes and per-type dots from the section's own voxels (padding excluded)
+    std::vector<uint16_t> stack; // Voxels as x | y << 4 | z << 8
+    for (const auto& t : types) {
+        uint16_t visited[16][16] = {}; // [y][z], bit = x
+        int sumX = 0, sumY = 0, sumZ = 0, total = 0;
+
+        for (int z = 0; z < 16; z++) {
+            for (int y = 0; y < 16; y++) {
+                uint16_t row;
+                while ((row = (uint16_t)(t.rowX[y + 1][z + 1] & ~visited[y][z])) != 0) {
+                    // Flood fill one vein (26-connected) from the first unvisited voxel
+                    int x = Ctz32(row);
+                    int minX = x, minY = y, minZ = z, maxX = x, maxY = y, maxZ = z, voxels = 0;
+                    visited[y][z] |= (uint16_t)(1u << x);
+                    stack.push_back((uint16_t)(x | (y << 4) | (z << 8)));
+
+                    while (!stack.empty()) {
+                        int v = stack.back();
+                        stack.pop_back();
+                        int vx = v & 15, vy = (v >> 4) & 15, vz = v >> 8;
+                        voxels++;
+                        sumX += vx * 2 + 1; sumY += vy * 2 + 1; sumZ += vz * 2 + 1;
+                        minX = (std::min)(minX, vx); maxX = (std::max)(maxX, vx);
+                        minY = (std::min)(minY, vy); maxY = (std::max)(maxY, vy);
+                        minZ = (std::min)(minZ, vz); maxZ = (std::max)(maxZ, vz);
+
+                        uint16_t span = (uint16_t)((7u << vx) >> 1); // vx-1 .. vx+1
+                        for (int ny = (std::max)(vy - 1, 0); ny <= (std::min)(vy + 1, 15); ny++) {
+                            for (int nz = (std::max)(vz - 1, 0); nz <= (std::min)(vz + 1, 15); nz++) {
+                                uint16_t next = (uint16_t)(t.rowX[ny + 1][nz + 1] & ~visited[ny][nz] & span);
+                                visited[ny][nz] |= next;
+                                while (next) {
+                                    int nx = Ctz32(next);
+                                    next &= (uint16_t)(next - 1);
+                                    stack.push_back((uint16_t)(nx | (ny << 4) | (nz << 8)));
+                                }
                             }
                         }
-                        if (!canExtend) break;
-                        h++;
                     }
 
-                    // Mark visited
-                    for (int dy = 0; dy < h; dy++) {
-                        for (int dx = 0; dx < w; dx++) {
-                            visited[v + dy][u + dx] = true;
+                    total += voxels;
+                    newMesh->boxes.push_back(PackBox(minX, minY, minZ, maxX - minX + 1, maxY - minY + 1, maxZ - minZ + 1, t.id, voxels));
+                }
+            }
+        }
+
+        if (total > 0) {
+            PackedDot dot;
+            dot.bits = (uint32_t)(sumX / total) | ((uint32_t)(sumY / total) << 6) | ((uint32_t)(sumZ / total) << 12);
+            dot.color = t.id;
+            dot.voxels = (uint16_t)total;
+            newMesh->dots.push_back(dot);
+        }
+    }
+
+    newMesh->edges.shrink_to_fit();
+    newMesh->faces.shrink_to_fit();
+    newMesh->boxes.shrink_to_fit();
+    newMesh->dots.shrink_to_fit();
+
+    // Tight bounds for culling, straight from the packed fields (min corner + extent)
+    int bMin[3] = { 16, 16, 16 };
+    int bMax[3] = { 0, 0, 0 };
+    auto growBounds = [&](uint32_t bits, int ex, int ey, int ez) {
+        int p[3] = { (int)(bits & 31), (int)((bits >> 5) & 31), (int)((bits >> 10) & 31) };
+        int e[3] = { ex, ey, ez };
+        for (int i = 0; i < 3; i++) {
+            bMin[i] = (std::min)(bMin[i], p[i]);
+            bMax[i] = (std::max)(bMax[i], p[i] + e[i]);
+        }
+    };
+    for (const auto& pe : newMesh->edges) {
+        int len = (int)((pe.bits >> 15) & 15) + 1;
+        int axis = (int)((pe.bits >> 19) & 3);
+        growBounds(pe.bits, axis == 0 ? len : 0, axis == 1 ? len : 0, axis == 2 ? len : 0);
+    }
+    for (const auto& pf : newMesh->faces) {
+        int w = (int)((pf.bits >> 15) & 15) + 1;
+        int h = (int)((pf.bits >> 19) & 15) + 1;
+        int dir = (int)((pf.bits >> 23) & 7);
+        if (dir == 0 || dir == 2)      growBounds(pf.bits, w, h, 0); // Z faces: U=X V=Y
+        else if (dir == 1 || dir == 3) growBounds(pf.bits, 0, h, w); // X faces: U=Z V=Y
+        else                           growBounds(pf.bits, w, 0, h); // Y faces: U=X V=Z
+    }
+    for (int i = 0; i < 3; i++) {
+        newMesh->boundsMin[i] = (uint8_t)bMin[i];
+        newMesh->boundsMax[i] = (uint8_t)bMax[i];
+    }
+    
+    // Swap the mesh. The old one stays alive for as long as a snapshot still points at it.
+    // Only the worker reads or writes chunk.mesh, the map lock just keeps the entry alive.
+    const_cast<CachedChunk&>(chunk).mesh = newMesh;
+    const_cast<CachedChunk&>(chunk).bytes = SectionBytes(chunk.blocks.size(), types.size(), *newMesh);
+}
+
+// Brings the vein clusters up to date with the sections re-meshed or erased since the last
+// snapshot. Their boxes are replaced, and only the clusters they belonged to or now touch are
+// relabelled, by a flood fill over touching boxes of one type in neighbouring sections
+// (including diagonally). Every cached mesh counts, drawn as geometry or not.
+void BlockESP::UpdateVeinClusters(const SectionSet& changed) {
+    using Key = std::tuple<int, int, int>;
+    auto offsetKey = [](const Key& k, int ox, int oy, int oz) {
+        return Key{ std::get<0>(k) + ox, std::get<1>(k) + oy, std::get<2>(k) + oz };
+    };
+
+    // Retiring a cluster leaves its boxes unlabelled, to be picked up by the fill below
+    std::vector<std::pair<Key, uint32_t>> seeds; // (section, box index)
+    auto retire = [&](uint32_t id) {
+        auto it = veinClusters.find(id);
+        if (it == veinClusters.end()) return;
+        for (const auto& key : it->second.sections) {
+            auto boxes = veinBoxes.find(key);
+            if (boxes == veinBoxes.end()) continue;
+            for (uint32_t i = 0; i < boxes->second.size(); i++) {
+                if (boxes->second[i].cluster != id) continue;
+                boxes->second[i].cluster = 0;
+                seeds.push_back({ key, i });
+            }
+        }
+        auto& cell = veinCells[it->second.cell];
+        cell.erase(std::remove(cell.begin(), cell.end(), id), cell.end());
+        dirtyVeinCells.insert(it->second.cell);
+        veinClusters.erase(it);
+    };
+
+    for (const auto& key : changed) {
+        auto old = veinBoxes.find(key);
+        if (old != veinBoxes.end()) {
+            for (const auto& box : old->second) {
+                if (box.cluster) retire(box.cluster);
+            }
+            veinBoxes.erase(old);
+        }
+
+        auto chunk = chunkMap.find(key);
+        if (chunk == chunkMap.end() || !chunk->second.mesh || chunk->second.mesh->boxes.empty()) continue;
+        const ChunkMesh* mesh = chunk->second.mesh.get();
+        auto& boxes = veinBoxes[key];
+        boxes.reserve(mesh->boxes.size());
+        for (const auto& pb : mesh->boxes) {
+            Vec3 lo, hi;
+            DecodeBox(pb, lo, hi);
+            VeinBox box;
+            box.border = (lo.x == 0) | ((hi.x == 16) << 1) | ((lo.y == 0) << 2) | ((hi.y == 16) << 3) | ((lo.z == 0) << 4) | ((hi.z == 16) << 5);
+            box.min[0] = mesh->originX + (int)lo.x; box.max[0] = mesh->originX + (int)hi.x;
+            box.min[1] = mesh->originY + (int)lo.y; box.max[1] = mesh->originY + (int)hi.y;
+            box.min[2] = mesh->originZ + (int)lo.z; box.max[2] = mesh->originZ + (int)hi.z;
+            box.color = pb.color;
+            box.voxels = pb.voxels;
+            box.cluster = 0;
+            seeds.push_back({ key, (uint32_t)boxes.size() });
+            boxes.push_back(box);
+        }
+    }
+
+    // A retired box can sit in a section that was itself replaced later in the loop above
+    auto boxAt = [&](const std::pair<Key, uint32_t>& ref) -> VeinBox* {
+        auto it = veinBoxes.find(ref.first);
+        return (it == veinBoxes.end() || ref.second >= it->second.size()) ? nullptr : &it->second[ref.second];
+    };
+
+    const int cell = RenderSnapshot::kClusterCell;
+    std::vector<std::pair<Key, uint32_t>> stack;
+    for (size_t s = 0; s < seeds.size(); s++) { // retire() appends to seeds
+        auto seed = seeds[s];
+        VeinBox* first = boxAt(seed);
+        if (!first || first->cluster) continue;
+
+        uint32_t id = nextVeinCluster++;
+        if (nextVeinCluster == 0) nextVeinCluster = 1; // 0 means unlabelled
+        VeinClusterState state;
+        VeinCluster& cluster = state.cluster;
+        cluster.minX = first->min[0]; cluster.minY = first->min[1]; cluster.minZ = first->min[2];
+        cluster.maxX = first->max[0]; cluster.maxY = first->max[1]; cluster.maxZ = first->max[2];
+        cluster.voxels = 0;
+        cluster.color = first->color;
+        double sums[3] = { 0.0, 0.0, 0.0 }; // Voxel-weighted box centres
+
+        first->cluster = id;
+        stack.push_back(seed);
+        while (!stack.empty()) {
+            auto ref = stack.back();
+            stack.pop_back();
+            const VeinBox box = *boxAt(ref);
+
+            cluster.minX = (std::min)(cluster.minX, box.min[0]); cluster.maxX = (std::max)(cluster.maxX, box.max[0]);
+            cluster.minY = (std::min)(cluster.minY, box.min[1]); cluster.maxY = (std::max)(cluster.maxY, box.max[1]);
+            cluster.minZ = (std::min)(cluster.minZ, box.min[2]); cluster.maxZ = (std::max)(cluster.maxZ, box.max[2]);
+            cluster.voxels += box.voxels;
+            for (int i = 0; i < 3; i++) sums[i] += (box.min[i] + box.max[i]) * 0.5 * box.voxels;
+            if (std::find(state.sections.begin(), state.sections.end(), ref.first) == state.sections.end()) {
+                state.sections.push_back(ref.first);
+            }
+            if (!box.border) continue;
+
+            // Neighbour sections on the faces, edges and corners this box touches
+            for (int ox = -1; ox <= 1; ox++) {
+                for (int oy = -1; oy <= 1; oy++) {
+                    for (int oz = -1; oz <= 1; oz++) {
+                        if (!ox && !oy && !oz) continue;
+                        uint8_t need = 0, needOther = 0;
+                        int offset[3] = { ox, oy, oz };
+                        for (int i = 0; i < 3; i++) {
+                            if (offset[i] > 0) { need |= 2 << (i * 2); needOther |= 1 << (i * 2); }
+                            else if (offset[i] < 0) { need |= 1 << (i * 2); needOther |= 2 << (i * 2); }
+                        }
+                        if ((box.border & need) != need) continue;
+
+                        Key nkey = offsetKey(ref.first, ox, oy, oz);
+                        auto it = veinBoxes.find(nkey);
+                        if (it == veinBoxes.end()) continue;
+                        for (uint32_t i = 0; i < it->second.size(); i++) {
+                            VeinBox& other = it->second[i];
+                            if (other.cluster == id || other.color != box.color || (other.border & needOther) != needOther) continue;
+                            if (box.min[0] > other.max[0] || other.min[0] > box.max[0] ||
+                                box.min[1] > other.max[1] || other.min[1] > box.max[1] ||
+                                box.min[2] > other.max[2] || other.min[2] > box.max[2]) continue;
+
+                            // Touches a vein that was not affected: it joins this one
+                            if (other.cluster) retire(other.cluster);
+                            other.cluster = id;
+                            stack.push_back({ nkey, i });
                         }
                     }
+                }
+            }
+        }
 
-                    // Create Face
-                    Face f;
-                    float x1, y1, z1, x2, y2, z2; // Local to chunk
-                    
-                    // Convert back to local coords
-                    if (dir == 0 || dir == 2) { // Z faces
-                         // u=x, v=y, d=z
-                         // Quad: (u, v, d) to (u+w, v+h, d)
-                         x1 = (float)u; y1 = (float)v; z1 = (float)d;
-                         x2 = (float)(u + w); y2 = (float)(v + h); z2 = (float)d;
-                         if (dir == 2) { z1 += 1.0f; z2 += 1.0f; } // +Z face
-                    } else if (dir == 1 || dir == 3) { // X faces
-                         // u=z, v=y, d=x
-                         x1 = (float)d; y1 = (float)v; z1 = (float)u;
-                         x2 = (float)d; y2 = (float)(v + h); z2 = (float)(u + w);
-                         if (dir == 1) { x1 += 1.0f; x2 += 1.0f; } // +X face
-                    } else { // Y faces
-                         // u=x, v=z, d=y
-                         x1 = (float)u; y1 = (float)d; z1 = (float)v;
-                         x2 = (float)(u + w); y2 = (float)d; z2 = (float)(v + h);
-                         if (dir == 4) { y1 += 1.0f; y2 += 1.0f; } // +Y face
-                    }
+        cluster.centerX = sums[0] / cluster.voxels;
+        cluster.centerY = sums[1] / cluster.voxels;
+        cluster.centerZ = sums[2] / cluster.voxels;
+        state.cell = Key{ (int)std::floor(cluster.centerX / cell), (int)std::floor(cluster.centerY / cell), (int)std::floor(cluster.centerZ / cell) };
+        veinCells[state.cell].push_back(id);
+        dirtyVeinCells.insert(state.cell);
+        veinClusters.emplace(id, std::move(state));
+    }
+}
 
-                    // Add to mesh (World Coords)
-                    f.x1 = startX + x1; f.y1 = startY + y1; f.z1 = startZ + z1;
-                    // ... Need 4 points for quad ...
-                    // Let's simplify: Store min/max and expand in Render?
-                    // No, Render expects 4 points.
-                    // Depending on axis, expand x2/y2/z2
-                    
-                    // Wait, previous implementation stored 4 points in Face?
-                    // Let's check struct Face
-                    // struct Face { float x1, y1, z1; float x2, y2, z2; float x3, y3, z3; float x4, y4, z4; };
-                    
-                    // We need to calculate the 4 corners based on orientation
-                    if (dir == 0) { // -Z (North)
-                        f.x1 = startX + x2; f.y1 = startY + y1; f.z1 = startZ + z1;
-                        f.x2 = startX + x1; f.y2 = startY + y1; f.z2 = startZ + z1;
-                        f.x3 = startX + x1; f.y3 = startY + y2; f.z3 = startZ + z1;
-                        f.x4 = startX + x2; f.y4 = startY + y2; f.z4 = startZ + z1;
-                    } else if (dir == 2) { // +Z (South)
-                        f.x1 = startX + x1; f.y1 = startY + y1; f.z1 = startZ + z1;
-                        f.x2 = startX + x2; f.y2 = startY + y1; f.z2 = startZ + z1;
-                        f.x3 = startX + x2; f.y3 = startY + y2; f.z3 = startZ + z1;
-                        f.x4 = startX + x1; f.y4 = startY + y2; f.z4 = startZ + z1;
-                    } else if (dir == 3) { // -X (West)
-                        f.x1 = startX + x1; f.y1 = startY + y1; f.z1 = startZ + z1;
-                        f.x2 = startX + x1; f.y2 = startY + y1; f.z2 = startZ + z2;
-                        f.x3 = startX + x1; f.y3 = startY + y2; f.z3 = startZ + z2;
-                        f.x4 = startX + x1; f.y4 = startY + y2; f.z4 = startZ + z1;
-                    } else if (dir == 1) { // +X (East)
-                        f.x1 = startX + x1; f.y1 = startY + y1; f.z1 = startZ + z2;
-                        f.x2 = startX + x1; f.y2 = startY + y1; f.z2 = startZ + z1;
-                        f.x3 = startX + x1; f.y3 = startY + y2; f.z3 = startZ + z1;
-                        f.x4 = startX + x1; f.y4 = startY + y2; f.z4 = startZ + z2;
-                    } else if (dir == 5) { // -Y (Down)
-                        f.x1 = startX + x1; f.y1 = startY + y1; f.z1 = startZ + z1;
-                        f.x2 = startX + x2; f.y2 = startY + y1; f.z2 = startZ + z1;
-                        f.x3 = startX + x2; f.y3 = startY + y1; f.z3 = startZ + z2;
-                        f.x4 = startX + x1; f.y4 = startY + y1; f.z4 = startZ + z2;
-                    } else if (dir == 4) { // +Y (Up)
-                        f.x1 = startX + x1; f.y1 = startY + y1; f.z1 = startZ + z2;
-                        f.x2 = startX + x2; f.y2 = startY + y1; f.z2 = startZ + z2;
-                        f.x3 = startX + x2; f.y3 = startY + y1; f.z3 = startZ + z1;
-                        f.x4 = startX + x1; f.y4 = startY + y1; f.z4 = startZ + z1;
-                    }
+// Stable far -> near counting sort of order (indices into sections) for a camera section.
+// Linear in the section count, no comparisons; shared by the worker and the draw order.
+static void SortFarToNear(const std::vector<RenderSnapshot::Section>& sections, std::vector<uint32_t>& order,
+                          int camCx, int camCy, int camCz,
+                          std::vector<int>& keys, std::vector<uint32_t>& buckets, std::vector<uint32_t>& scratch) {
+    keys.resize(sections.size());
+    int maxKey = 0;
+    for (size_t i = 0; i < sections.size(); i++) {
+        keys[i] = RenderSnapshot::OrderKey(sections[i], camCx, camCy, camCz);
+        maxKey = (std::max)(maxKey, keys[i]);
+    }
+
+    buckets.assign(maxKey + 2, 0);
+    for (int key : keys) buckets[maxKey - key + 1]++; // Far first
+    for (int k = 1; k <= maxKey + 1; k++) buckets[k] += buckets[k - 1];
+
+    // Walk the previous order so sections at equal distance keep their relative order
+    scratch.resize(order.size());
+    for (uint32_t idx : order) {
+        scratch[buckets[maxKey - keys[idx]]++] = idx;
+    }
+    order.swap(scratch);
+}
+
+void BlockESP::PublishSnapshot() {
+    auto snapshot = std::make_shared<RenderSnapshot>();
+    std::shared_ptr<const RenderSnapshot> previous = std::atomic_load(&renderSnapshot);
+    const bool fromScratch = orderStale || !previous; // Nothing to carry over (cache cleared or replaced)
+
+    // Sorted for where the camera is now, so Render starts from an ordered list
+    // and only has to patch it up if the camera moved on since
+    snapshot->sortCx = cameraCx;
+    snapshot->sortCy = cameraCy;
+    snapshot->sortCz = cameraCz;
+    auto orderKey = [&](const RenderSnapshot::Section& s) {
+        return RenderSnapshot::OrderKey(s, snapshot->sortCx, snapshot->sortCy, snapshot->sortCz);
+    };
+
+    auto makeSection = [](const std::tuple<int, int, int>& key, const std::shared_ptr<const ChunkMesh>& mesh) {
+        RenderSnapshot::Section section;
+        section.cx = std::get<0>(key);
+        section.cy = std::get<1>(key);
+        section.cz = std::get<2>(key);
+        section.centerX = (mesh->boundsMin[0] + mesh->boundsMax[0]) * 0.5f;
+        section.centerY = (mesh->boundsMin[1] + mesh->boundsMax[1]) * 0.5f;
+        section.centerZ = (mesh->boundsMin[2] + mesh->boundsMax[2]) * 0.5f;
+        section.halfX = (mesh->boundsMax[0] - mesh->boundsMin[0]) * 0.5f;
+        section.halfY = (mesh->boundsMax[1] - mesh->boundsMin[1]) * 0.5f;
+        section.halfZ = (mesh->boundsMax[2] - mesh->boundsMin[2]) * 0.5f;
+        section.mesh = mesh;
+        return section;
+    };
+    auto drawable = [](const std::shared_ptr<const ChunkMesh>& mesh) {
+        return mesh && !(mesh->edges.empty() && mesh->faces.empty());
+    };
+
+    {
+        std::shared_lock<std::shared_mutex> lock(chunkMapMutex);
+        snapshot->chunkCount = chunkMap.size();
+
+        for (const auto& [key, chunk] : chunkMap) {
+            {
+                std::lock_guard<std::mutex> blockLock(chunk.blockMutex);
+                snapshot->blockCount += chunk.blocks.size();
+            }
+            snapshot->cacheBytes += chunk.bytes;
+
+            const auto& mesh = chunk.mesh;
+            if (!mesh) continue;
+            snapshot->meshBytes += mesh->edges.capacity() * sizeof(PackedEdge) + mesh->faces.capacity() * sizeof(PackedFace) +
+                                   mesh->boxes.capacity() * sizeof(PackedBox) + mesh->dots.capacity() * sizeof(PackedDot);
+        }
 
-                    newMesh->faces.push_back({blockInfos[id].faceColor, f});
-
-                    // Add Edges
-                    // Only add edges that are on the border of the greedy quad
-                    // Or simply add 4 lines for the quad
-                    // Better: Add segments to tempEdges for merging
-                    
-                    // Bottom/Top horizontal
-                    // Left/Right vertical
-                    
-                    TempEdge e; e.color = blockInfos[id].color;
-                    
-                    // ... Edge extraction logic ...
-                    // Simplifying for brevity/correctness based on previous logic:
-                    // Previous logic extracted edges from faces?
-                    // Actually, let's just add the 4 edges of the quad to tempEdges
-                    
-                    // Edge 1
-                    e.x1 = f.x1; e.y1 = f.y1; e.z1 = f.z1;
-                    e.x2 = f.x2; e.y2 = f.y2; e.z2 = f.z2;
-                    // determine axis
-                    if (e.x1 != e.x2) e.axis = 0; else if (e.y1 != e.y2) e.axis = 1; else e.axis = 2;
-                    // normalize (x1 < x2 etc)
-                    if (e.x1 > e.x2 || e.y1 > e.y2 || e.z1 > e.z2) { std::swap(e.x1, e.x2); std::swap(e.y1, e.y2); std::swap(e.z1, e.z2); }
-                    tempEdges.push_back(e);
-
-                    // Edge 2
-                    e.x1 = f.x2; e.y1 = f.y2; e.z1 = f.z2;
-                    e.x2 = f.x3; e.y2 = f.y3; e.z2 = f.z3;
-                    if (e.x1 != e.x2) e.axis = 0; else if (e.y1 != e.y2) e.axis = 1; else e.axis = 2;
-                    if (e.x1 > e.x2 || e.y1 > e.y2 || e.z1 > e.z2) { std::swap(e.x1, e.x2); std::swap(e.y1, e.y2); std::swap(e.z1, e.z2); }
-                    tempEdges.push_back(e);
-
-                    // Edge 3
-                    e.x1 = f.x3; e.y1 = f.y3; e.z1 = f.z3;
-                    e.x2 = f.x4; e.y2 = f.y4; e.z2 = f.z4;
-                    if (e.x1 != e.x2) e.axis = 0; else if (e.y1 != e.y2) e.axis = 1; else e.axis = 2;
-                    if (e.x1 > e.x2 || e.y1 > e.y2 || e.z1 > e.z2) { std::swap(e.x1, e.x2); std::swap(e.y1, e.y2); std::swap(e.z1, e.z2); }
-                    tempEdges.push_back(e);
-
-                    // Edge 4
-                    e.x1 = f.x4; e.y1 = f.y4; e.z1 = f.z4;
-                    e.x2 = f.x1; e.y2 = f.y1; e.z2 = f.z1;
-                    if (e.x1 != e.x2) e.axis = 0; else if (e.y1 != e.y2) e.axis = 1; else e.axis = 2;
-                    if (e.x1 > e.x2 || e.y1 > e.y2 || e.z1 > e.z2) { std::swap(e.x1, e.x2); std::swap(e.y1, e.y2); std::swap(e.z1, e.z2); }
-                    tempEdges.push_back(e);
+        // Veins first: the order upkeep below consumes meshChanged
+        UpdateVeinClusters(meshChanged);
+
+        auto& sections = snapshot->sections;
+        auto bucketAll = [&]() {
+            std::vector<int> keys;
+            std::vector<uint32_t> order(sections.size()), buckets, scratch;
+            for (uint32_t i = 0; i < order.size(); i++) order[i] = i;
+            SortFarToNear(sections, order, snapshot->sortCx, snapshot->sortCy, snapshot->sortCz, keys, buckets, scratch);
+            std::vector<RenderSnapshot::Section> sorted;
+            sorted.reserve(sections.capacity());
+            for (uint32_t idx : order) sorted.push_back(std::move(sections[idx]));
+            sections.swap(sorted);
+        };
+
+        if (fromScratch) {
+            // Every section, bucketed once
+            sections.reserve(chunkMap.size());
+            for (const auto& [key, chunk] : chunkMap) {
+                if (drawable(chunk.mesh)) sections.push_back(makeSection(key, chunk.mesh));
+            }
+            bucketAll();
+        } else {
+            // Carry the previous order. A re-meshed section keeps its key, so it is refreshed
+            // in place; erased or emptied ones drop out. What is left in meshChanged is new.
+            sections.reserve(previous->sections.size() + meshChanged.size());
+            for (const auto& s : previous->sections) {
+                std::tuple<int, int, int> key{ s.cx, s.cy, s.cz };
+                auto changed = meshChanged.find(key);
+                if (changed == meshChanged.end()) {
+                    sections.push_back(s);
+                    continue;
                 }
+                meshChanged.erase(changed);
+                auto it = chunkMap.find(key);
+                if (it != chunkMap.end() && drawable(it->second.mesh)) sections.push_back(makeSection(key, it->second.mesh));
+            }
+
+            std::vector<RenderSnapshot::Section> inserted;
+            for (const auto& key : meshChanged) {
+                auto it = chunkMap.find(key);
+                if (it != chunkMap.end() && drawable(it->second.mesh)) inserted.push_back(makeSection(key, it->second.mesh));
+            }
+
+            // Camera crossed a section boundary since: re-bucket what was carried over first
+            if (previous->sortCx != snapshot->sortCx || previous->sortCy != snapshot->sortCy || previous->sortCz != snapshot->sortCz) {
+                bucketAll();
+            }
+
+            // Only the new sections need a comparison sort, then one merge
+            if (!inserted.empty()) {
+                auto farther = [&](const RenderSnapshot::Section& a, const RenderSnapshot::Section& b) { return orderKey(a) > orderKey(b); };
+                std::sort(inserted.begin(), inserted.end(), farther);
+                size_t carried = sections.size();
+                sections.insert(sections.end(), std::make_move_iterator(inserted.begin()), std::make_move_iterator(inserted.end()));
+                std::inplace_merge(sections.begin(), sections.begin() + carried, sections.end(), farther);
             }
         }
+
+        meshChanged.clear();
+        orderStale = false;
     }
 
-    // Merge Edges
-    std::sort(tempEdges.begin(), tempEdges.end());
-    
-    if (!tempEdges.empty()) {
-        TempEdge current = tempEdges[0];
-        // We need to count duplicates. If an edge is shared by 2 faces (e.g. 90 degree turn), we keep it.
-        // If it's shared by 2 coplanar faces, it shouldn't exist because we greedy meshed faces.
-        // Wait, 4 edges per quad. Adjacent quads share an edge.
-        // If we draw wireframe, we want that edge? 
-        // Actually, we usually want outlines.
-        // If an edge is present TWICE (shared by 2 faces), it might be an internal edge or a corner.
-        // If it is shared by faces with different normals (corner), we want it.
-        // If it is shared by faces with same normal (internal), we don't want it (but greedy meshing removes internal edges).
-        // So duplicates here mean corners or T-junctions.
-        // We can just draw all unique edges?
-        // Or merging collinear edges.
-        
-        // Let's just merge collinear edges regardless of duplicates for now to match previous behavior?
-        // Previous behavior:
-        /*
-            if (sameLine) {
-                 // extend
+    // Vein grid: cells nothing changed in are shared with the previous snapshot
+    if (!fromScratch) snapshot->clusterGrid = previous->clusterGrid;
+    for (const auto& key : dirtyVeinCells) {
+        auto it = veinCells.find(key);
+        if (it == veinCells.end() || it->second.empty()) {
+            if (it != veinCells.end()) veinCells.erase(it);
+            snapshot->clusterGrid.erase(key);
+            continue;
+        }
+        auto cellClusters = std::make_shared<RenderSnapshot::ClusterCell>();
+        cellClusters->reserve(it->second.size());
+        for (uint32_t id : it->second) cellClusters->push_back(veinClusters.at(id).cluster);
+        snapshot->clusterGrid[key] = std::move(cellClusters);
+    }
+    dirtyVeinCells.clear();
+    bool firstCell = true;
+    for (const auto& [key, cell] : snapshot->clusterGrid) {
+        int k[3] = { std::get<0>(key), std::get<1>(key), std::get<2>(key) };
+        for (int i = 0; i < 3; i++) {
+            snapshot->gridMin[i] = firstCell ? k[i] : (std::min)(snapshot->gridMin[i], k[i]);
+            snapshot->gridMax[i] = firstCell ? k[i] : (std::max)(snapshot->gridMax[i], k[i]);
+        }
+        snapshot->clusterCount += cell->size();
+        firstCell = false;
+    }
+
+    std::atomic_store(&renderSnapshot, std::shared_ptr<const RenderSnapshot>(std::move(snapshot)));
+}
+
+std::vector<VeinCluster> BlockESP::NearestVeins(const std::string& blockId, double x, double y, double z, size_t count,
+                                                const std::vector<bool>* visible) {
+    std::vector<VeinCluster> result;
+    std::shared_ptr<const RenderSnapshot> snapshot = std::atomic_load(&renderSnapshot);
+    if (!snapshot || snapshot->clusterGrid.empty() || count == 0) return result;
+
+    uint16_t color = 0; // Any type
+    if (!blockId.empty()) {
+        std::lock_guard<std::mutex> lock(paletteMutex);
+        auto it = globalPaletteMap.find(blockId);
+        if (it == globalPaletteMap.end()) return result;
+        color = it->second;
+    }
+
+    // Search shells of grid cells outward from the query cell. Everything in shell r is at
+    // least r - 1 cells away, so once the farthest of the best `count` is closer than that
+    // no later shell can improve the result.
+    const int cell = RenderSnapshot::kClusterCell;
+    int q[3] = { (int)std::floor(x / cell), (int)std::floor(y / cell), (int)std::floor(z / cell) };
+    int maxR = 0;
+    for (int i = 0; i < 3; i++) {
+        maxR = (std::max)(maxR, (std::max)(std::abs(q[i] - snapshot->gridMin[i]), std::abs(snapshot->gridMax[i] - q[i])));
+    }
+
+    std::vector<std::pair<double, const VeinCluster*>> best; // Max-heap on squared distance, at most count entries
+    auto consider = [&](const RenderSnapshot::ClusterCell& bucket) {
+        for (const VeinCluster& cluster : bucket) {
+            const VeinCluster* c = &cluster;
+            if (color != 0 && cluster.color != color) continue;
+            if (visible && (cluster.color >= visible->size() || !(*visible)[cluster.color])) continue;
+            double dx = cluster.centerX - x, dy = cluster.centerY - y, dz = cluster.centerZ - z;
+            double distSq = dx * dx + dy * dy + dz * dz;
+            if (best.size() < count) {
+                best.push_back({ distSq, c });
+                std::push_heap(best.begin(), best.end());
+            } else if (distSq < best.front().first) {
+                std::pop_heap(best.begin(), best.end());
+                best.back() = { distSq, c };
+                std::push_heap(best.begin(), best.end());
             }
-        */
-        
-        // Actually, logic is:
-        // Iterate sorted edges.
-        // If current edge overlaps/touches next edge AND same color AND same axis AND same constant coords:
-        // Merge them.
-        
-        for (size_t i = 1; i < tempEdges.size(); i++) {
-            TempEdge& next = tempEdges[i];
-            
-            bool sameLine = false;
-            if (current.color == next.color && current.axis == next.axis) {
-                 if (current.axis == 0) { // X variable
-                     sameLine = (current.y1 == next.y1) && (current.z1 == next.z1);
-                 } else if (current.axis == 1) { // Y variable
-                     sameLine = (current.x1 == next.x1) && (current.z1 == next.z1);
-                 } else { // Z variable
-                     sameLine = (current.x1 == next.x1) && (current.y1 == next.y1);
-                 }
+        }
+    };
+
+    for (int r = 0; r <= maxR; r++) {
+        if (best.size() == count && r > 1) {
+            double reach = (r - 1) * (double)cell;
+            if (reach * reach >= best.front().first) break;
+        }
+        for (int dx = -r; dx <= r; dx++) {
+            for (int dy = -r; dy <= r; dy++) {
+                // Inner cells of this slab belong to earlier shells: only the two z faces are new
+                bool onShell = std::abs(dx) == r || std::abs(dy) == r;
+                int step = (onShell || r == 0) ? 1 : 2 * r;
+                for (int dz = -r; dz <= r; dz += step) {
+                    auto it = snapshot->clusterGrid.find({ q[0] + dx, q[1] + dy, q[2] + dz });
+                    if (it != snapshot->clusterGrid.end()) consider(*it->second);
+                }
             }
+        }
+    }
+
+    std::sort_heap(best.begin(), best.end());
+    result.reserve(best.size());
+    for (const auto& entry : best) result.push_back(*entry.second);
+    return result;
+}
+
+void BlockESP::UpdateDrawOrder(const std::shared_ptr<const RenderSnapshot>& snapshot, int camCx, int camCy, int camCz) {
+    if (snapshot != orderedSnapshot) {
+        // New snapshot: it arrives sorted for the camera section the worker saw
+        orderedSnapshot = snapshot;
+        drawOrder.resize(snapshot->sections.size());
+        for (uint32_t i = 0; i < drawOrder.size(); i++) drawOrder[i] = i;
+        orderedCx = snapshot->sortCx;
+        orderedCy = snapshot->sortCy;
+        orderedCz = snapshot->sortCz;
+    }
+
+    if (orderedCx == camCx && orderedCy == camCy && orderedCz == camCz) return;
+
+    // Camera crossed a section boundary: re-bucket by the new distance keys
+    SortFarToNear(snapshot->sections, drawOrder, camCx, camCy, camCz, drawOrderKeys, drawOrderBuckets, drawOrderScratch);
+
+    orderedCx = camCx;
+    orderedCy = camCy;
+    orderedCz = camCz;
+}
+
+// World cache file (native little-endian): header, palette as (u16 length, name) per slot,
+// then per section: i32 cx, cy, cz, u32 count, count x (u16 local index, u16 palette slot).
+// Meshes are not stored: palette IDs differ between runs and re-meshing is cheap.
+struct WorldCacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t paletteCount;
+    uint32_t sectionCount;
+};
+static const uint32_t kWorldCacheMagic = 0x31434258; // "XBC1"
+static const uint32_t kWorldCacheVersion = 1;
+
+void BlockESP::SaveWorldCache(const std::string& path) {
+    auto start = std::chrono::high_resolution_clock::now();
+
+    std::vector<std::string> names;
+    {
+        std::lock_guard<std::mutex> lock(paletteMutex);
+        names = globalPalette;
+    }
 
-            if (sameLine) {
-                float currEnd = (current.axis == 0) ? current.x2 : ((current.axis == 1) ? current.y2 : current.z2);
-                float nextStart = (next.axis == 0) ? next.x1 : ((next.axis == 1) ? next.y1 : next.z1);
-                
-                if (currEnd >= nextStart - 0.001f) { // Overlap or touch
-                    float nextEnd = (next.axis == 0) ? next.x2 : ((next.axis == 1) ? next.y2 : next.z2);
-                    if (nextEnd > currEnd) {
-                        if (current.axis == 0) current.x2 = nextEnd;
-                        else if (current.axis == 1) current.y2 = nextEnd;
-                        else current.z2 = nextEnd;
+    // Only the block types present get a slot
+    std::vector<int> slotOf(names.size() + 1, -1);
+    std::vector<const std::string*> palette;
+    std::string body;
+    uint32_t sectionCount = 0;
+    {
+        std::shared_lock<std::shared_mutex> lock(chunkMapMutex);
+        for (const auto& [key, chunk] : chunkMap) {
+            std::lock_guard<std::mutex> blockLock(chunk.blockMutex);
+            if (chunk.blocks.empty()) continue;
+
+            int32_t pos[3] = { std::get<0>(key), std::get<1>(key), std::get<2>(key) };
+            uint32_t count = (uint32_t)chunk.blocks.size();
+            body.append((const char*)pos, sizeof(pos));
+            body.append((const char*)&count, sizeof(count));
+            for (const auto& [index, id] : chunk.blocks) {
+                uint16_t entry[2] = { (uint16_t)index, 0xFFFF }; // Unknown IDs are skipped on load
+                if (id > 0 && id < slotOf.size()) {
+                    if (slotOf[id] < 0) {
+                        slotOf[id] = (int)palette.size();
+                        palette.push_back(&names[id - 1]);
                     }
-                    continue; 
+                    entry[1] = (uint16_t)slotOf[id];
                 }
+                body.append((const char*)entry, sizeof(entry));
             }
-            
-            Edge e;
-            e.x1 = current.x1; e.y1 = current.y1; e.z1 = current.z1;
-            e.x2 = current.x2; e.y2 = current.y2; e.z2 = current.z2;
-            newMesh->edges.push_back({current.color, e});
-            
-            current = next;
+            sectionCount++;
         }
-        Edge e;
-        e.x1 = current.x1; e.y1 = current.y1; e.z1 = current.z1;
-        e.x2 = current.x2; e.y2 = current.y2; e.z2 = current.z2;
-        newMesh->edges.push_back({current.color, e});
     }
 
-    newMesh->edges.shrink_to_fit();
-    newMesh->faces.shrink_to_fit();
-    
-    // Swap the mesh
+    // Write beside the old file and swap, so a crash mid-write never leaves a torn cache
+    std::error_code ec;
+    fs::create_directories(fs::path(path).parent_path(), ec);
+    std::string tmpPath = path + ".tmp";
     {
-        std::lock_guard<std::mutex> lock(chunk.meshMutex);
-        // We need to cast away constness of 'chunk' to modify 'mesh'
-        // Since we accessed it via at() on a non-const map?
-        // Wait, I used const auto& chunk = chunkMap.at(chunkPos);
-        // This makes 'chunk' const.
-        // But 'meshMutex' is mutable.
-        // 'mesh' is NOT mutable.
-        // So I need non-const reference.
-        // Since I hold shared_lock, accessing map via non-const is... undefined if I modify the map structure.
-        // But I am modifying the VALUE (chunk).
-        // Does shared_lock allow modifying values?
-        // Yes, if the map is not const.
-        // shared_lock only guarantees multiple readers.
-        // If I modify the object *in place* (thread safe internally), it is fine.
-        // So I should use auto& chunk = chunkMap.at(chunkPos);
-        // But chunkMap is not const? Yes.
-        // But wait, if I use shared_lock, I shouldn't modify the container structure.
-        // But modifying the element is fine if it doesn't race with other readers of THAT element.
-        // Render reads THAT element (mesh pointer).
-        // I protect mesh pointer with meshMutex.
-        // So it is safe.
-        // So I just need to remove 'const' from 'chunk'.
-        const_cast<CachedChunk&>(chunk).mesh = newMesh;
+        std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+        WorldCacheHeader header = { kWorldCacheMagic, kWorldCacheVersion, (uint32_t)palette.size(), sectionCount };
+        file.write((const char*)&header, sizeof(header));
+        for (const std::string* name : palette) {
+            uint16_t len = (uint16_t)name->size();
+            file.write((const char*)&len, sizeof(len));
+            file.write(name->data(), len);
+        }
+        file.write(body.data(), body.size());
+        if (!file) {
+            printf("[BlockESP] Could not write world cache %s\n", tmpPath.c_str());
+            return;
+        }
+    }
+    fs::rename(tmpPath, path, ec);
+    if (ec) {
+        printf("[BlockESP] Could not replace world cache %s: %s\n", path.c_str(), ec.message().c_str());
+        return;
     }
+
+    cacheDirty = false;
+    lastCacheSave = std::chrono::steady_clock::now();
+    printf("[BlockESP] Saved world cache %s: %u sections, %.1fKB in %.2fms\n", path.c_str(), sectionCount,
+           (sizeof(WorldCacheHeader) + body.size()) / 1024.0,
+           std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+}
+
+void BlockESP::LoadWorldCache(const std::string& path) {
+    auto start = std::chrono::high_resolution_clock::now();
+
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return; // Nothing cached for this world yet
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart < (LONGLONG)sizeof(WorldCacheHeader)) {
+        CloseHandle(file);
+        return;
+    }
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    const uint8_t* view = mapping ? (const uint8_t*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (!view) {
+        if (mapping) CloseHandle(mapping);
+        CloseHandle(file);
+        return;
+    }
+
+    // Parse straight out of the mapping; running past the end means a truncated or foreign file
+    const uint8_t* cursor = view;
+    const uint8_t* end = view + fileSize.QuadPart;
+    auto read = [&](void* out, size_t n) {
+        if ((size_t)(end - cursor) < n) return false;
+        memcpy(out, cursor, n);
+        cursor += n;
+        return true;
+    };
+
+    std::map<std::tuple<int, int, int>, CachedChunk> loaded;
+    WorldCacheHeader header;
+    bool ok = read(&header, sizeof(header)) && header.magic == kWorldCacheMagic && header.version == kWorldCacheVersion;
+    if (ok) {
+        std::vector<uint16_t> idOf(header.paletteCount);
+        for (uint32_t i = 0; i < header.paletteCount && ok; i++) {
+            uint16_t len;
+            ok = read(&len, sizeof(len)) && (size_t)(end - cursor) >= len;
+            if (ok) {
+                idOf[i] = GetBlockID(std::string((const char*)cursor, len));
+                cursor += len;
+            }
+        }
+        for (uint32_t i = 0; i < header.sectionCount && ok; i++) {
+            int32_t pos[3];
+            uint32_t count;
+            ok = read(pos, sizeof(pos)) && read(&count, sizeof(count)) && (size_t)(end - cursor) / 4 >= count;
+            if (!ok) break;
+
+            auto& blocks = loaded[{pos[0], pos[1], pos[2]}].blocks;
+            for (uint32_t b = 0; b < count; b++) {
+                uint16_t entry[2];
+                memcpy(entry, cursor, sizeof(entry));
+                cursor += sizeof(entry);
+                if (entry[0] < 4096 && entry[1] < idOf.size()) blocks.emplace_hint(blocks.end(), entry[0], idOf[entry[1]]);
+            }
+        }
+    }
+
+    UnmapViewOfFile(view);
+    CloseHandle(mapping);
+    CloseHandle(file);
+
+    if (!ok) {
+        printf("[BlockESP] Ignoring unreadable world cache %s\n", path.c_str());
+        return;
+    }
+
+    size_t sectionCount = loaded.size();
+    {
+        std::unique_lock<std::shared_mutex> lock(chunkMapMutex);
+        for (const auto& [pos, chunk] : loaded) {
+            for (const auto& [index, id] : chunk.blocks) {
+                if (id >= typeSections.size()) typeSections.resize(id + 1);
+                typeSections[id].insert(pos);
+            }
+        }
+        chunkMap.merge(loaded); // Moves the nodes, sections already present keep theirs
+    }
+    {
+        std::shared_lock<std::shared_mutex> lock(chunkMapMutex);
+        for (const auto& [pos, chunk] : chunkMap) {
+            UpdateChunk(pos);
+        }
+    }
+
+    printf("[BlockESP] Loaded world cache %s: %zu sections in %.2fms\n", path.c_str(), sectionCount,
+           std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+}
+
+// Over the memory budget (the BlockESP heap as MemTrack counts it): evicts whole columns
+// outside keepRange of the camera, least recently visible first and the farthest first among
+// equals, down to 90% of the budget. When what is in range doesn't fit either, the range is
+// lowered a column at a time (budgetRange) and given back once the heap is well under budget.
+// Returns whether anything went; the main thread hands the columns to the mod.
+bool BlockESP::EvictOverBudget() {
+    size_t budget = memoryBudget.load(std::memory_order_relaxed);
+    if (budget == 0) return false;
+    size_t used = (size_t)(std::max)(MemTrack::Stats(MemTag::BlockESP).liveBytes.load(std::memory_order_relaxed), (int64_t)0);
+    auto now = std::chrono::steady_clock::now();
+
+    if (used <= budget) {
+        // Slower to widen than to narrow, so the range doesn't hunt around the budget
+        int limit = budgetRange.load(std::memory_order_relaxed);
+        if (limit != 0 && used < budget / 10 * 7 && now - lastBudgetRangeChange >= std::chrono::seconds(5)) {
+            budgetRange.compare_exchange_strong(limit, limit + 16, std::memory_order_relaxed);
+            lastBudgetRangeChange = now;
+            printf("[BlockESP] Memory budget: range back up to %d blocks\n", limit + 16);
+        }
+        return false;
+    }
+
+    struct Column {
+        std::pair<int, int> pos;
+        size_t bytes = 0;
+        long long lastVisible = 0;
+        long long distSq = 0;
+    };
+    std::map<std::pair<int, int>, Column> columns;
+    {
+        std::shared_lock<std::shared_mutex> lock(chunkMapMutex);
+        for (const auto& [key, chunk] : chunkMap) {
+            Column& column = columns[{ std::get<0>(key), std::get<2>(key) }];
+            column.bytes += chunk.bytes;
+            if (chunk.mesh) column.lastVisible = (std::max)(column.lastVisible, chunk.mesh->lastVisibleMs.load(std::memory_order_relaxed));
+        }
+    }
+
+    int camCx = cameraCx, camCz = cameraCz;
+    long long keep = keepRange.load(std::memory_order_relaxed) / 16 + 1;
+    std::vector<Column> candidates;
+    for (auto& [pos, column] : columns) {
+        long long dx = pos.first - camCx, dz = pos.second - camCz;
+        column.pos = pos;
+        column.distSq = dx * dx + dz * dz;
+        if (column.distSq > keep * keep) candidates.push_back(column);
+    }
+    std::sort(candidates.begin(), candidates.end(), [](const Column& a, const Column& b) {
+        if (a.lastVisible != b.lastVisible) return a.lastVisible < b.lastVisible;
+        return a.distSq > b.distSq;
+    });
+
+    size_t target = budget / 10 * 9; // Headroom, so the next batch doesn't evict again
+    size_t before = used;
+    std::vector<std::pair<int, int>> evicted;
+    for (const auto& column : candidates) {
+        if (used <= target) break;
+        used -= (std::min)(used, column.bytes);
+        evicted.push_back(column.pos);
+    }
+
+    // What is left lies in range: shrink the range. The subscription follows, so the mod drops
+    // the columns beyond it and the ring in between becomes evictable. Paced so each step
+    // takes effect before the next.
+    int range = keepRange.load(std::memory_order_relaxed) - 24;
+    if (used > budget && range > 16 && now - lastBudgetRangeChange >= std::chrono::seconds(2)) {
+        int lowered = (std::max)(range - 16, 16);
+        budgetRange.store(lowered, std::memory_order_relaxed);
+        lastBudgetRangeChange = now;
+        printf("[BlockESP] Memory budget %.1fMB is below the %.1fMB in range, range lowered to %d blocks\n",
+               budget / (1024.0 * 1024.0), used / (1024.0 * 1024.0), lowered);
+    }
+    if (evicted.empty()) return false;
+
+    UnloadColumns(evicted);
+    workerEvicted.insert(evicted.begin(), evicted.end());
+    {
+        std::lock_guard<std::mutex> lock(evictMutex);
+        newlyEvicted.insert(newlyEvicted.end(), evicted.begin(), evicted.end());
+    }
+    cacheDirty = true;
+    printf("[BlockESP] Memory budget: evicted %zu columns, %.1fMB -> %.1fMB of %.1fMB\n", evicted.size(),
+           before / (1024.0 * 1024.0), used / (1024.0 * 1024.0), budget / (1024.0 * 1024.0));
+    return true;
+}
+
+// Drops whole chunk columns (unloaded by the mod, or evicted) and re-meshes what borders them
+void BlockESP::UnloadColumns(const std::vector<std::pair<int, int>>& columns) {
+    SectionSet borderSections; // Read the unloaded columns as padding
+    {
+        std::unique_lock<std::shared_mutex> lock(chunkMapMutex);
+        for (const auto& p : columns) {
+            // Optimization: Instead of scanning the entire map (O(N)), 
+            // we probe the likely vertical chunk range (O(Log N)).
+            // Standard Minecraft is Y=-64 to 320 (cy -4 to 20).
+            // We scan -64 to 64 to be safe (Y -1024 to +1024).
+            for (int cy = -64; cy <= 64; cy++) {
+                auto it = chunkMap.find({p.first, cy, p.second});
+                if (it == chunkMap.end()) continue;
+                for (const auto& [index, id] : it->second.blocks) {
+                    if (id < typeSections.size()) typeSections[id].erase(it->first);
+                }
+                meshChanged.insert(it->first);
+                chunkMap.erase(it);
+
+                for (int ox = -1; ox <= 1; ox++) {
+                    for (int oy = -1; oy <= 1; oy++) {
+                        for (int oz = -1; oz <= 1; oz++) {
+                            if ((ox || oz) && !(ox && oy && oz)) borderSections.insert({p.first + ox, cy + oy, p.second + oz});
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // Surviving neighbours lose their padding there: faces toward the gap reappear and
+    // seam edges the unloaded side used to own are now emitted by them
+    std::shared_lock<std::shared_mutex> lock(chunkMapMutex);
+    for (const auto& pos : borderSections) {
+        if (chunkMap.count(pos)) UpdateChunk(pos);
+    }
+}
+
+// Column hash shared with the mod (BlockESP.java columnHash): FNV-1a 64 over the column's
+// blocks ordered by (section y, index in section), each fed as i32 section y and u16 index
+// (both little-endian), the block id's bytes, then a 0 byte. An empty column hashes to the basis.
+void BlockESP::BuildManifest(std::vector<ColumnHash>& out) {
+    auto start = std::chrono::high_resolution_clock::now();
+
+    std::vector<std::string> names;
+    {
+        std::lock_guard<std::mutex> lock(paletteMutex);
+        names = globalPalette;
+    }
+
+    auto feed = [](uint64_t hash, uint8_t byte) { return (hash ^ byte) * 1099511628211ULL; };
+
+    // chunkMap is ordered by (cx, cy, cz): a column's sections are met in cy order,
+    // interleaved with the other columns of the same cx
+    std::map<std::pair<int, int>, uint64_t> columns;
+    {
+        std::shared_lock<std::shared_mutex> lock(chunkMapMutex);
+        for (const auto& [key, chunk] : chunkMap) {
+            std::lock_guard<std::mutex> blockLock(chunk.blockMutex);
+            if (chunk.blocks.empty()) continue;
+
+            auto inserted = columns.insert({ { std::get<0>(key), std::get<2>(key) }, 14695981039346656037ULL });
+            uint64_t hash = inserted.first->second;
+            uint32_t cy = (uint32_t)std::get<1>(key);
+            for (const auto& [index, id] : chunk.blocks) {
+                if (id == 0 || id > names.size()) continue;
+                for (int i = 0; i < 4; i++) hash = feed(hash, (uint8_t)(cy >> (i * 8)));
+                hash = feed(hash, (uint8_t)index);
+                hash = feed(hash, (uint8_t)(index >> 8));
+                for (unsigned char c : names[id - 1]) hash = feed(hash, c);
+                hash = feed(hash, 0);
+            }
+            inserted.first->second = hash;
+        }
+    }
+
+    out.reserve(columns.size());
+    for (const auto& [column, hash] : columns) {
+        out.push_back({ column.first, column.second, hash });
+    }
+    printf("[BlockESP] Manifest: %zu columns in %.2fms\n", out.size(),
+           std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+}
+
+// Re-subscribe when the camera changes section or the range changes; a turn only reorders the
+// mod's queue, so it is sent at most every 250ms and only past 30 degrees.
+// Range the cache holds data for: the render range, unless the memory budget lowered it
+int BlockESP::DataRange() {
+    int limit = budgetRange.load(std::memory_order_relaxed);
+    if (limit == 0) return renderRange;
+    if (limit >= renderRange) {
+        budgetRange.compare_exchange_strong(limit, 0, std::memory_order_relaxed); // Caught up
+        return renderRange;
+    }
+    return limit;
+}
+
+void BlockESP::UpdateSubscription(const GameData& data, float screenW, float screenH) {
+    int cx = (int)std::floor(data.camX / 16.0);
+    int cy = (int)std::floor(data.camY / 16.0);
+    int cz = (int)std::floor(data.camZ / 16.0);
+    int range = DataRange() + 24; // Same chunk radius buffer as the draw limit
+
+    long long now = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    float turn = std::fabs(std::remainder(data.camYaw - subscribedYaw, 360.0f));
+    bool moved = cx != subscribedCx || cy != subscribedCy || cz != subscribedCz || range != subscribedRange;
+    if (!subscriptionStale && !moved && (turn < 30.0f || now - lastSubscription < 250)) return;
+
+    float halfFovY = data.fov * 0.5f * (3.14159f / 180.0f);
+    float halfFovX = std::atan(std::tan(halfFovY) * screenW / screenH) * (180.0f / 3.14159f);
+    if (!net->SendSubscription(range, cx, cy, cz, true, data.camYaw, halfFovX)) return;
+
+    subscriptionStale = false;
+    subscribedRange = range;
+    subscribedCx = cx;
+    subscribedCy = cy;
+    subscribedCz = cz;
+    subscribedYaw = data.camYaw;
+    lastSubscription = now;
 }
 
 void BlockESP::WorkerLoop() {
+    MemScope memScope(MemTag::BlockESP); // Everything this thread allocates is cache or mesh data
+
+    // Debugging
+    long long totalUpdateTime = 0;
+    long long totalRebuildTime = 0;
+    int totalRebuilds = 0;
+    size_t maxQueueDepth = 0;    // Batches waiting at wake-up
+    long long maxQueueWait = 0;  // Oldest batch age at wake-up (us)
+    auto lastDebugTime = std::chrono::steady_clock::now();
+
     while (!shouldStop) {
         std::vector<BlockUpdate> updates;
+        std::vector<SectionBlocks> sections;
         std::vector<std::pair<int, int>> unloads;
+        std::vector<uint16_t> typeRemovals;
+        bool clearCache = false;
+        bool switchWorld = false, loadWorld = false, sendManifest = false, remeshAll = false;
+        std::string worldFile;
         
         {
             std::unique_lock<std::mutex> lock(queueMutex);
-            queueCV.wait(lock, [this] { return shouldStop || !updateQueue.empty() || !unloadQueue.empty(); });
-            
-            if (shouldStop) break;
-            
-            if (!updateQueue.empty()) {
-                updates = std::move(updateQueue.front());
-                updateQueue.pop();
+            queueCV.wait(lock, [this] { return shouldStop || hasDeferredBatch || !workerRing.Empty(); });
+        }
+        if (shouldStop) break;
+
+        // Coalesce every queued batch so a section touched by several
+        // batches is only re-meshed once
+        auto popTime = std::chrono::steady_clock::now();
+        size_t depth = workerRing.Size();
+        auto nextBatch = [this](WorkerBatch& out) {
+            if (!hasDeferredBatch) return workerRing.TryPop(out);
+            out = std::move(deferredBatch);
+            deferredBatch = WorkerBatch();
+            hasDeferredBatch = false;
+            return true;
+        };
+        WorkerBatch batch;
+        bool merged = false;
+        while (nextBatch(batch)) {
+            long long waitUs = std::chrono::duration_cast<std::chrono::microseconds>(popTime - batch.queuedAt).count();
+            maxQueueWait = (std::max)(maxQueueWait, waitUs);
+
+            // What was merged before a world switch is the previous world's last data: it is
+            // applied and saved with that world in this pass, the switch opens the next one
+            if (batch.switchWorld && merged) {
+                deferredBatch = std::move(batch);
+                hasDeferredBatch = true;
+                break;
             }
-            while (!unloadQueue.empty()) {
-                unloads.push_back(unloadQueue.front());
-                unloadQueue.pop();
+            merged = true;
+
+            if (batch.switchWorld) {
+                // First batch of its pass: the cache still holds the previous world, saved below
+                switchWorld = true;
+                loadWorld = true;
+                worldFile = std::move(batch.worldFile);
+            }
+            if (batch.clearFirst || batch.switchWorld) {
+                // Everything merged so far predates the clear and is thrown away with it
+                if (!batch.switchWorld) loadWorld = false; // A clear after the switch drops the loaded cache too
+                clearCache = true;
+                unloads.clear();
+                updates.clear();
+                sections.clear();
+                typeRemovals.clear();
+                workerEvicted.clear(); // The main thread forgot them with the clear
+            }
+            // All unloads of the pass run before all updates: what earlier batches queued for
+            // these columns would otherwise be re-added after the unload
+            DropUnloadedColumns(updates, sections, batch.unloads);
+            unloads.insert(unloads.end(), batch.unloads.begin(), batch.unloads.end());
+
+            // Evicted columns: whatever the mod sent before it forgot them is dropped, until
+            // the main thread asks for them back
+            for (const auto& column : batch.restored) workerEvicted.erase(column);
+            if (!workerEvicted.empty()) {
+                auto evicted = [&](int x, int z) { return workerEvicted.count({ x >> 4, z >> 4 }) != 0; };
+                batch.updates.erase(std::remove_if(batch.updates.begin(), batch.updates.end(),
+                    [&](const BlockUpdate& u) { return evicted(u.x, u.z); }), batch.updates.end());
+                batch.sections.erase(std::remove_if(batch.sections.begin(), batch.sections.end(),
+                    [&](const SectionBlocks& s) { return workerEvicted.count({ s.cx, s.cz }) != 0; }), batch.sections.end());
+            }
+
+            if (updates.empty()) {
+                updates = std::move(batch.updates);
+            } else {
+                updates.insert(updates.end(), std::make_move_iterator(batch.updates.begin()), std::make_move_iterator(batch.updates.end()));
             }
+            sections.insert(sections.end(), std::make_move_iterator(batch.sections.begin()), std::make_move_iterator(batch.sections.end()));
+            typeRemovals.insert(typeRemovals.end(), batch.typeRemovals.begin(), batch.typeRemovals.end());
+            sendManifest |= batch.sendManifest;
+            remeshAll |= batch.remeshAll;
+
+            // Removals run after updates, so later batches (which may re-add the type) wait for the next pass
+            if (!batch.typeRemovals.empty()) break;
         }
+        maxQueueDepth = (std::max)(maxQueueDepth, depth);
 
-        if (!unloads.empty()) {
+        if (switchWorld && cacheDirty && !cacheFile.empty()) {
+            SaveWorldCache(cacheFile);
+        }
+
+        if (clearCache) {
             std::unique_lock<std::shared_mutex> lock(chunkMapMutex);
-            for (const auto& p : unloads) {
-                // Optimization: Instead of scanning the entire map (O(N)), 
-                // we probe the likely vertical chunk range (O(Log N)).
-                // Standard Minecraft is Y=-64 to 320 (cy -4 to 20).
-                // We scan -64 to 64 to be safe (Y -1024 to +1024).
-                for (int cy = -64; cy <= 64; cy++) {
-                    chunkMap.erase({p.first, cy, p.second});
-                }
-            }
+            chunkMap.clear();
+            typeSections.clear();
+            meshChanged.clear();
+            orderStale = true;
+            veinBoxes.clear();
+            veinClusters.clear();
+            veinCells.clear();
+            dirtyVeinCells.clear();
+        }
+
+        if (switchWorld) {
+            cacheFile = worldFile;
+            cacheDirty = false;
+            lastCacheSave = std::chrono::steady_clock::now();
+            if (loadWorld && !cacheFile.empty()) LoadWorldCache(cacheFile);
         }
+        if (!unloads.empty() || !updates.empty() || !sections.empty() || !typeRemovals.empty() || (clearCache && !switchWorld)) cacheDirty = true;
 
-        if (!updates.empty()) {
+        if (!unloads.empty()) {
+            UnloadColumns(unloads);
+        }
+
+        if (!updates.empty() || !sections.empty()) {
             long long t1, t2;
-            ProcessUpdates(updates, t1, t2);
+            int rebuilt;
+            ProcessUpdates(updates, sections, t1, t2, rebuilt);
+            totalUpdateTime += t1;
+            totalRebuildTime += t2;
+            totalRebuilds += rebuilt;
+        }
+
+        // After updates: a type is removed once the mod stopped streaming it
+        if (!typeRemovals.empty()) {
+            ProcessTypeRemovals(typeRemovals);
+        }
+
+        if (remeshAll) {
+            std::shared_lock<std::shared_mutex> lock(chunkMapMutex);
+            for (const auto& [pos, chunk] : chunkMap) UpdateChunk(pos);
+        }
+
+        // Every wake-up changed the cache in some way, hand the result to the renderer
+        PublishSnapshot();
+        if (EvictOverBudget()) {
+            PublishSnapshot();
+        }
+
+        if (sendManifest) {
+            std::vector<ColumnHash> manifest;
+            BuildManifest(manifest);
+            std::lock_guard<std::mutex> lock(manifestMutex);
+            readyManifest = std::move(manifest);
+            manifestReady = true;
+        }
+
+        // Keep the file fresh enough that a crash only loses the last half minute
+        if (cacheDirty && !cacheFile.empty() &&
+            std::chrono::steady_clock::now() - lastCacheSave >= std::chrono::seconds(30)) {
+            SaveWorldCache(cacheFile);
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (totalRebuilds > 0 && std::chrono::duration_cast<std::chrono::seconds>(now - lastDebugTime).count() >= 1) {
+            printf("[Perf] BlockESP Worker: Update=%.2fms, Rebuild=%.2fms, Sections=%d (%.1fus/section), Queue=%zu/%zu, Wait=%.2fms\n",
+                   totalUpdateTime / 1000.0, totalRebuildTime / 1000.0, totalRebuilds, totalRebuildTime / (double)totalRebuilds,
+                   maxQueueDepth, workerRing.capacity, maxQueueWait / 1000.0);
+            lastDebugTime = now;
+            totalUpdateTime = 0;
+            totalRebuildTime = 0;
+            totalRebuilds = 0;
+            maxQueueDepth = 0;
+            maxQueueWait = 0;
         }
     }
 }
 
-void BlockESP::Render(const GameData& data, float screenW, float screenH, ImDrawList* draw) {
+void BlockESP::Render(GameData& data, float screenW, float screenH, ImDrawList* draw) {
     if (!enabled) return;
+    MemScope memScope(MemTag::BlockESP);
 
-    // clear data if not connected
+    // Not connected: keep the cache, the next connection resyncs it by column hashes
     if (!net->IsConnected()) {
-        std::unique_lock<std::shared_mutex> lock(chunkMapMutex);
-        chunkMap.clear();
+        data.worldKey.clear();
+        awaitingIdentity = true;
+        subscriptionStale = true;
+        // The mod forgets its evictions on a new connection and streams those columns normally
+        {
+            std::lock_guard<std::mutex> lock(evictMutex);
+            evictedColumns.insert(newlyEvicted.begin(), newlyEvicted.end());
+            newlyEvicted.clear();
+        }
+        if (!evictedColumns.empty()) {
+            WorkerBatch& batch = PendingBatch();
+            batch.restored.insert(batch.restored.end(), evictedColumns.begin(), evictedColumns.end());
+            evictedColumns.clear();
+        }
+        FlushPendingBatch();
         return;
     }
 
-    if (data.shouldClearBlocks) {
-        std::unique_lock<std::shared_mutex> lock(chunkMapMutex);
-        chunkMap.clear();
+    // The mod names the world on every connect and world change: park the previous world on
+    // disk and start from this one's cache, then offer the mod our column hashes so it only
+    // resends the columns that differ
+    if (!data.worldKey.empty() && (awaitingIdentity || data.worldKey != worldKey)) {
+        if (data.worldKey != worldKey) {
+            // Data read ahead of the identity packet is the old world's last, handed over before
+            // the switch (which drops whatever is still pending)
+            if (data.worldSplit) {
+                std::vector<BlockUpdate> updates(std::make_move_iterator(data.blockUpdates.begin()),
+                                                 std::make_move_iterator(data.blockUpdates.begin() + data.splitUpdates));
+                std::vector<SectionBlocks> sections(std::make_move_iterator(data.sectionBlocks.begin()),
+                                                    std::make_move_iterator(data.sectionBlocks.begin() + data.splitSections));
+                std::vector<std::pair<int, int>> unloads(data.chunksToUnload.begin(), data.chunksToUnload.begin() + data.splitUnloads);
+                data.blockUpdates.erase(data.blockUpdates.begin(), data.blockUpdates.begin() + data.splitUpdates);
+                data.sectionBlocks.erase(data.sectionBlocks.begin(), data.sectionBlocks.begin() + data.splitSections);
+                data.chunksToUnload.erase(data.chunksToUnload.begin(), data.chunksToUnload.begin() + data.splitUnloads);
+                QueueBlockData(updates, sections, unloads);
+                FlushPendingBatch();
+            }
+            SwitchWorld(data.worldKey);
+        }
+        PendingBatch().sendManifest = true;
+        awaitingIdentity = false;
     }
-
-    if (!data.blocksToDelete.empty()) {
-        for (const auto& id : data.blocksToDelete) {
-            RemoveBlocks(id);
+    {
+        std::lock_guard<std::mutex> lock(manifestMutex);
+        if (manifestReady) {
+            net->SendManifest(readyManifest);
+            readyManifest.clear();
+            manifestReady = false;
         }
-        // Rebuild is handled in RemoveBlocks? No, RemoveBlocks just modifies blocks.
-        // We need to trigger rebuild.
-        RebuildAllChunks();
     }
 
-    // Push unloads to worker
-    if (!data.chunksToUnload.empty()) {
-        {
-            std::lock_guard<std::mutex> lock(queueMutex);
-            for (const auto& chunk : data.chunksToUnload) {
-                unloadQueue.push(chunk);
-            }
-        }
-        queueCV.notify_one();
+    memoryBudget.store((size_t)memoryBudgetMB << 20, std::memory_order_relaxed);
+    keepRange.store(DataRange() + 24, std::memory_order_relaxed);
+    viewX = data.camX;
+    viewY = data.camY;
+    viewZ = data.camZ;
+    UpdateSubscription(data, screenW, screenH);
+    UpdateEvictions(data);
+    FlushTypeChanges();
+
+    if (data.shouldClearBlocks) {
+        ClearCache();
     }
 
-    // Push updates to worker
-    if (!data.blockUpdates.empty()) {
-        {
-            std::lock_guard<std::mutex> lock(queueMutex);
-            updateQueue.push(data.blockUpdates);
-        }
-        queueCV.notify_one();
+    // Removal and the re-mesh of affected sections happen on the worker
+    for (const auto& id : data.blocksToDelete) {
+        RemoveBlocks(id);
     }
 
+    // Hand this frame's unloads and updates to the worker (moved, main loop clears them after)
+    QueueBlockData(data.blockUpdates, data.sectionBlocks, data.chunksToUnload);
+    FlushPendingBatch();
+
     auto startRender = std::chrono::high_resolution_clock::now();
 
-    // Precompute ViewState
-    ViewState viewState = PrecomputeViewState(data.camYaw, data.camPitch, data.fov, screenW, screenH);
+    RefreshPaletteColors();
+
+    // Precompute ViewState (game matrix when the mod sent one, yaw/pitch otherwise)
+    ViewState viewState = data.hasViewProj ? PrecomputeViewState(data.viewProj, screenW, screenH)
+                                           : PrecomputeViewState(data.camYaw, data.camPitch, data.fov, screenW, screenH);
 
     // Render loop
     int drawnEdges = 0;
-    float limitDist = (float)renderRange + 24.0f; // Range + Chunk Radius buffer
+    int culledSections = 0;
+    int projectedVerts = 0;
+    const float nearZ = 0.1f;
+    int dataRange = DataRange(); // Nothing is cached past it
+    if (!adaptiveRange || effectiveRange > dataRange) effectiveRange = (float)dataRange;
+    float limitDist = effectiveRange + 24.0f; // Range + Chunk Radius buffer
     float limitSq = limitDist * limitDist;
     
-    // Acquire Read Lock
-    std::shared_lock<std::shared_mutex> lock(chunkMapMutex);
-
-    // Collect and sort chunks for Painter's Algorithm (Far -> Near)
-    struct RenderableChunk {
-        float distSq;
-        const CachedChunk* chunk;
-    };
-    std::vector<RenderableChunk> renderList;
-    renderList.reserve(chunkMap.size());
+    // Latest worker snapshot. Holding the pointer keeps it and its meshes alive for the frame,
+    // no locks are taken and the worker is free to rebuild or unload meanwhile.
+    std::shared_ptr<const RenderSnapshot> snapshot = std::atomic_load(&renderSnapshot);
+    if (!snapshot) return;
+
+    // Painter's Algorithm (Far -> Near): ordering is kept between frames and only
+    // patched when the camera changes section or a new snapshot arrives
+    int camCx = (int)std::floor(data.camX / 16.0);
+    int camCy = (int)std::floor(data.camY / 16.0);
+    int camCz = (int)std::floor(data.camZ / 16.0);
+    cameraCx = camCx;
+    cameraCy = camCy;
+    cameraCz = camCz;
+    UpdateDrawOrder(snapshot, camCx, camCy, camCz);
+
+    renderList.clear();
+    long long frameMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
     
-    for (const auto& [key, chunk] : chunkMap) {
-        // Distance Check (Chunk Center)
-        float cx = (std::get<0>(key) * 16) + 8.0f;
-        float cy = (std::get<1>(key) * 16) + 8.0f;
-        float cz = (std::get<2>(key) * 16) + 8.0f;
-        
-        float distSq = (cx - data.camX) * (cx - data.camX) + 
-                       (cy - data.camY) * (cy - data.camY) + 
-                       (cz - data.camZ) * (cz - data.camZ);
+    for (uint32_t sectionIndex : drawOrder) {
+        const auto& section = snapshot->sections[sectionIndex];
+        const ChunkMesh* mesh = section.mesh.get();
+
+        // The only double-precision step: once per section per frame. Everything below works
+        // in small camera-relative floats, so precision doesn't degrade far from spawn.
+        Vec3 offset = { (float)(mesh->originX - data.camX), (float)(mesh->originY - data.camY), (float)(mesh->originZ - data.camZ) };
+
+        // Distance Check (Mesh Center)
+        float dx = offset.x + section.centerX;
+        float dy = offset.y + section.centerY;
+        float dz = offset.z + section.centerZ;
+        float distSq = dx * dx + dy * dy + dz * dz;
                        
         if (distSq > limitSq) continue;
+
+        // Whole section outside the view: none of its vertices get transformed
+        if (!AabbInFrustum({dx, dy, dz}, {section.halfX, section.halfY, section.halfZ}, viewState, nearZ)) {
+            culledSections++;
+            continue;
+        }
         
-        renderList.push_back({distSq, &chunk});
+        mesh->lastVisibleMs.store(frameMs, std::memory_order_relaxed);
+
+        // LOD by how many pixels one block covers at the section's distance
+        float blockPx = ProjectedSize(1.0f, (std::max)(sqrtf(distSq), 1.0f), viewState);
+        MeshLod lod = blockPx >= lodMeshPx ? LodMesh : (blockPx >= lodBoxPx ? LodBoxes : LodDots);
+
+        renderList.push_back({offset, {dx, dy, dz}, mesh, lod, DrawFull});
     }
 
-    // Sort: Furthest first (Painter's Algorithm)
-    std::sort(renderList.begin(), renderList.end(), [](const RenderableChunk& a, const RenderableChunk& b) {
-        return a.distSq > b.distSq;
-    });
+    // Far veins: one marker per cluster, labelled with its block count, where a block is
+    // too small for outlines. Sections at dot LOD leave their far field to these, except for
+    // the types no marker stands for (a vein whose centroid is near enough for boxes). Drawn
+    // before any section, as everything still drawn as geometry is nearer.
+    int farVeins = 0;
+    markedTypes.clear();
+    const float cellReach = RenderSnapshot::kClusterCell * 0.8660254f; // Half the cell diagonal
+    for (const auto& [cellKey, cell] : snapshot->clusterGrid) {
+        // Whole cell out of range: its veins are all farther than the limit
+        float cellX = (float)((std::get<0>(cellKey) + 0.5) * RenderSnapshot::kClusterCell - data.camX);
+        float cellY = (float)((std::get<1>(cellKey) + 0.5) * RenderSnapshot::kClusterCell - data.camY);
+        float cellZ = (float)((std::get<2>(cellKey) + 0.5) * RenderSnapshot::kClusterCell - data.camZ);
+        float cellDist = (std::max)(sqrtf(cellX * cellX + cellY * cellY + cellZ * cellZ) - cellReach, 0.0f);
+        if (cellDist * cellDist > limitSq) continue;
+
+        for (const auto& cluster : *cell) {
+            if (cluster.color >= paletteColors.size() || !paletteColors[cluster.color].visible) continue;
+            float rx = (float)(cluster.centerX - data.camX);
+            float ry = (float)(cluster.centerY - data.camY);
+            float rz = (float)(cluster.centerZ - data.camZ);
+            float distSq = rx * rx + ry * ry + rz * rz;
+            if (distSq > limitSq) continue;
+            if (ProjectedSize(1.0f, (std::max)(sqrtf(distSq), 1.0f), viewState) >= lodBoxPx) continue;
+
+            Vec3 c = WorldToCamera(rx, ry, rz, viewState);
+            if (FrustumOutcode(c, viewState, nearZ)) continue;
+            Vec2 p = CameraToScreen(c, viewState);
+            ImU32 col = paletteColors[cluster.color].edge;
+            draw->AddRectFilled(ImVec2(p.x - 1.5f, p.y - 1.5f), ImVec2(p.x + 1.5f, p.y + 1.5f), col);
+            if (cluster.voxels > 1) {
+                char label[16];
+                snprintf(label, sizeof(label), "%u", cluster.voxels);
+                draw->AddText(ImVec2(p.x + 3.0f, p.y - 7.0f), col, label);
+            }
+            farVeins++;
+            for (int sx = cluster.minX >> 4; sx <= (cluster.maxX - 1) >> 4; sx++) {
+                for (int sy = cluster.minY >> 4; sy <= (cluster.maxY - 1) >> 4; sy++) {
+                    for (int sz = cluster.minZ >> 4; sz <= (cluster.maxZ - 1) >> 4; sz++) {
+                        markedTypes.insert({ sx, sy, sz, cluster.color });
+                    }
+                }
+            }
+        }
+    }
+
+    auto isMarked = [&](const ChunkMesh& mesh, uint16_t color) {
+        return markedTypes.count({ mesh.originX >> 4, mesh.originY >> 4, mesh.originZ >> 4, color }) != 0;
+    };
+
+    // Frame budget: hand out detail near-first in primitives, using the measured cost per
+    // primitive. Once a section is degraded everything farther is at most as detailed.
+    const float totalBudget = frameBudgetMs * 1000.0f / (std::max)(usPerPrimitive, 0.001f);
+    float primitiveBudget = totalBudget - farVeins;
+    int edgeOnlySections = 0, markerSections = 0, skippedSections = 0;
+    {
+        DrawLevel floorLevel = DrawFull;
+        for (auto it = renderList.rbegin(); it != renderList.rend(); ++it) {
+            const ChunkMesh* mesh = it->mesh;
+            float markerCost = (float)(std::max)(mesh->dots.size(), (size_t)1);
+            float fullCost, edgeCost;
+            if (it->lod == LodMesh) {
+                fullCost = (float)(mesh->faces.size() + mesh->edges.size());
+                edgeCost = (float)mesh->edges.size();
+            } else if (it->lod == LodBoxes) {
+                fullCost = edgeCost = mesh->boxes.size() * 12.0f;
+            } else {
+                // Covered by the vein markers above, apart from the types none stands for
+                markerCost = 0.0f;
+                for (const auto& pd : mesh->dots) markerCost += isMarked(*mesh, pd.color) ? 0.0f : 1.0f;
+                fullCost = edgeCost = markerCost;
+            }
+
+            DrawLevel level = DrawSkip;
+            if (floorLevel <= DrawFull && fullCost <= primitiveBudget) level = DrawFull;
+            else if (floorLevel <= DrawEdges && edgeCost <= primitiveBudget) level = DrawEdges;
+            else if (markerCost <= primitiveBudget) level = DrawMarker;
+
+            if (level == DrawFull) primitiveBudget -= fullCost;
+            else if (level == DrawEdges) { primitiveBudget -= edgeCost; edgeOnlySections++; }
+            else if (level == DrawMarker) { primitiveBudget -= markerCost; markerSections++; }
+            else skippedSections++;
+
+            floorLevel = (std::max)(floorLevel, level);
+            it->level = level;
+        }
+    }
+
+    long long projectTime = 0;
+
+    // Draws projected vertices a-b as a line, clipped against the near plane
+    auto drawLine = [&](size_t a, size_t b, ImU32 col) {
+        const uint8_t* codes = projection.outcodes.data();
+        if (codes[a] & codes[b]) return;
+
+        if (!((codes[a] | codes[b]) & OutNear)) {
+            Vec2 p1 = projection.Screen(a);
+            Vec2 p2 = projection.Screen(b);
+            draw->AddLine(ImVec2(p1.x, p1.y), ImVec2(p2.x, p2.y), col);
+        } else {
+            Vec3 v1 = projection.Camera(a);
+            Vec3 v2 = projection.Camera(b);
+            float t = (nearZ - v1.z) / (v2.z - v1.z);
+            Vec3 intersect = { v1.x + (v2.x - v1.x)*t, v1.y + (v2.y - v1.y)*t, nearZ };
+
+            Vec3 start = (v1.z >= nearZ) ? v1 : intersect;
+            Vec3 end = (v2.z >= nearZ) ? v2 : intersect;
+
+            Vec2 p1 = CameraToScreen(start, viewState);
+            Vec2 p2 = CameraToScreen(end, viewState);
+            draw->AddLine(ImVec2(p1.x, p1.y), ImVec2(p2.x, p2.y), col);
+        }
+        drawnEdges++;
+    };
 
     for (const auto& rc : renderList) {
-        const CachedChunk& chunk = *rc.chunk;
-        
-        // Get Mesh safely
-        std::shared_ptr<ChunkMesh> mesh;
-        {
-            std::lock_guard<std::mutex> meshLock(chunk.meshMutex);
-            mesh = chunk.mesh;
+        const ChunkMesh* mesh = rc.mesh;
+        const Vec3& off = rc.offset;
+
+        if (rc.level == DrawSkip) continue;
+
+        if (rc.level == DrawMarker || rc.lod == LodDots) {
+            // Over budget, or too far for boxes: one dot per block type at the centroid of its
+            // voxels in the section. At dot LOD only for the types no vein marker stands for.
+            for (const auto& pd : mesh->dots) {
+                if (pd.color >= paletteColors.size() || !paletteColors[pd.color].visible) continue;
+                if (rc.lod == LodDots && isMarked(*mesh, pd.color)) continue;
+                Vec3 d = DecodeDot(pd);
+                Vec3 c = WorldToCamera(off.x + d.x, off.y + d.y, off.z + d.z, viewState);
+                if (FrustumOutcode(c, viewState, nearZ)) continue;
+                Vec2 p = CameraToScreen(c, viewState);
+                draw->AddRectFilled(ImVec2(p.x - 1.5f, p.y - 1.5f), ImVec2(p.x + 1.5f, p.y + 1.5f), paletteColors[pd.color].edge);
+            }
+            continue;
         }
-        
-        if (!mesh) continue;
 
-        for (const auto& facePair : mesh->faces) {
-             ImU32 col = facePair.first;
-             const Face& f = facePair.second;
-             
-             // Camera Space
-             Vec3 v1 = WorldToCamera(f.x1 - data.camX, f.y1 - data.camY, f.z1 - data.camZ, viewState);
-             Vec3 v2 = WorldToCamera(f.x2 - data.camX, f.y2 - data.camY, f.z2 - data.camZ, viewState);
-             Vec3 v3 = WorldToCamera(f.x3 - data.camX, f.y3 - data.camY, f.z3 - data.camZ, viewState);
-             Vec3 v4 = WorldToCamera(f.x4 - data.camX, f.y4 - data.camY, f.z4 - data.camZ, viewState);
-             
-             bool allIn = (v1.z > 0.1f && v2.z > 0.1f && v3.z > 0.1f && v4.z > 0.1f);
-             bool allOut = (v1.z <= 0.1f && v2.z <= 0.1f && v3.z <= 0.1f && v4.z <= 0.1f);
+        if (rc.lod == LodBoxes) {
+            // Mid field: one outline per vein, 8 corners each (index bits: 1 = x, 2 = y, 4 = z)
+            static const uint8_t boxEdges[12][2] = {
+                {0, 1}, {2, 3}, {4, 5}, {6, 7}, {0, 2}, {1, 3}, {4, 6}, {5, 7}, {0, 4}, {1, 5}, {2, 6}, {3, 7}
+            };
+            projection.Clear();
+            for (const auto& pb : mesh->boxes) {
+                if (pb.color >= paletteColors.size() || !paletteColors[pb.color].visible) continue;
+                Vec3 lo, hi;
+                DecodeBox(pb, lo, hi);
+                for (int i = 0; i < 8; i++) {
+                    projection.Push(off.x + ((i & 1) ? hi.x : lo.x), off.y + ((i & 2) ? hi.y : lo.y), off.z + ((i & 4) ? hi.z : lo.z));
+                }
+            }
+            if (projection.Size() == 0) continue;
+
+            auto startProject = std::chrono::high_resolution_clock::now();
+            ProjectBatch(projection, viewState, nearZ);
+            projectTime += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - startProject).count();
+            projectedVerts += (int)projection.Size();
+
+            size_t k = 0;
+            for (const auto& pb : mesh->boxes) {
+                if (pb.color >= paletteColors.size() || !paletteColors[pb.color].visible) continue;
+                ImU32 col = paletteColors[pb.color].edge;
+                for (const auto& e : boxEdges) drawLine(k + e[0], k + e[1], col);
+                k += 8;
+            }
+            continue;
+        }
+
+        bool drawFaces = (rc.level == DrawFull);
+
+        // Gather every visible vertex of the section, then project them in one batch:
+        // 4 per face (unless edges only) followed by 2 per edge, in mesh order
+        projection.Clear();
+        for (const auto& pf : mesh->faces) {
+             if (!drawFaces) break;
+             if (pf.color >= paletteColors.size() || !paletteColors[pf.color].visible) continue;
+             Vec3 c[4];
+             DecodeFace(pf, c);
+             for (int i = 0; i < 4; i++) {
+                 projection.Push(off.x + c[i].x, off.y + c[i].y, off.z + c[i].z);
+             }
+        }
+        for (const auto& pe : mesh->edges) {
+             if (pe.color >= paletteColors.size() || !paletteColors[pe.color].visible) continue;
+             Vec3 c[2];
+             DecodeEdge(pe, c);
+             for (int i = 0; i < 2; i++) {
+                 projection.Push(off.x + c[i].x, off.y + c[i].y, off.z + c[i].z);
+             }
+        }
+        if (projection.Size() == 0) continue;
+
+        auto startProject = std::chrono::high_resolution_clock::now();
+        ProjectBatch(projection, viewState, nearZ);
+        projectTime += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - startProject).count();
+        projectedVerts += (int)projection.Size();
+
+        const uint8_t* codes = projection.outcodes.data();
+        size_t k = 0; // Vertex cursor, same walk as the gather above
+
+        for (const auto& pf : mesh->faces) {
+             if (!drawFaces) break;
+             if (pf.color >= paletteColors.size() || !paletteColors[pf.color].visible) continue;
+             ImU32 col = paletteColors[pf.color].face;
+             size_t v = k;
+             k += 4;
 
-             if (allOut) continue;
+             // Every corner beyond the same plane (near or a guard-banded screen edge): off-screen
+             if (codes[v] & codes[v + 1] & codes[v + 2] & codes[v + 3]) continue;
+             
+             bool allIn = !((codes[v] | codes[v + 1] | codes[v + 2] | codes[v + 3]) & OutNear);
 
              if (allIn) {
-                 Vec2 p1 = CameraToScreen(v1, viewState);
-                 Vec2 p2 = CameraToScreen(v2, viewState);
-                 Vec2 p3 = CameraToScreen(v3, viewState);
-                 Vec2 p4 = CameraToScreen(v4, viewState);
+                 Vec2 p1 = projection.Screen(v);
+                 Vec2 p2 = projection.Screen(v + 1);
+                 Vec2 p3 = projection.Screen(v + 2);
+                 Vec2 p4 = projection.Screen(v + 3);
                  draw->AddQuadFilled(ImVec2(p1.x, p1.y), ImVec2(p2.x, p2.y), ImVec2(p3.x, p3.y), ImVec2(p4.x, p4.y), col);
              } else {
                  // Clipping
-                 Vec3 input[4] = {v1, v2, v3, v4};
+                 Vec3 input[4] = {projection.Camera(v), projection.Camera(v + 1), projection.Camera(v + 2), projection.Camera(v + 3)};
                  Vec3 output[8];
                  int outCount = 0;
-                 float nearZ = 0.1f;
                  
                  const Vec3* prev = &input[3];
                  float prevD = prev->z - nearZ;
@@ -1249,67 +2689,70 @@ void BlockESP::Render(const GameData& data, float screenW, float screenH, ImDraw
              }
         }
 
-        for (const auto& edgePair : mesh->edges) {
-             ImU32 col = edgePair.first;
-             const Edge& e = edgePair.second;
-             
-             Vec3 v1 = WorldToCamera(e.x1 - data.camX, e.y1 - data.camY, e.z1 - data.camZ, viewState);
-             Vec3 v2 = WorldToCamera(e.x2 - data.camX, e.y2 - data.camY, e.z2 - data.camZ, viewState);
-
-             if (v1.z <= 0.1f && v2.z <= 0.1f) continue;
-             
-             if (v1.z > 0.1f && v2.z > 0.1f) {
-                 Vec2 p1 = CameraToScreen(v1, viewState);
-                 Vec2 p2 = CameraToScreen(v2, viewState);
-                 draw->AddLine(ImVec2(p1.x, p1.y), ImVec2(p2.x, p2.y), col);
-                 drawnEdges++;
-             } else {
-                 float t = (0.1f - v1.z) / (v2.z - v1.z);
-                 Vec3 intersect = { v1.x + (v2.x - v1.x)*t, v1.y + (v2.y - v1.y)*t, 0.1f };
-                 
-                 Vec3 start = (v1.z > 0.1f) ? v1 : intersect;
-                 Vec3 end = (v2.z > 0.1f) ? v2 : intersect;
-                 
-                 Vec2 p1 = CameraToScreen(start, viewState);
-                 Vec2 p2 = CameraToScreen(end, viewState);
-                 draw->AddLine(ImVec2(p1.x, p1.y), ImVec2(p2.x, p2.y), col);
-                 drawnEdges++;
-             }
+        for (const auto& pe : mesh->edges) {
+             if (pe.color >= paletteColors.size() || !paletteColors[pe.color].visible) continue;
+             ImU32 col = paletteColors[pe.color].edge;
+             drawLine(k, k + 1, col);
+             k += 2;
         }
     }
 
     auto endRender = std::chrono::high_resolution_clock::now();
     long long renderTime = std::chrono::duration_cast<std::chrono::microseconds>(endRender - startRender).count();
+
+    // Feed the cost model; tiny frames are mostly fixed overhead and would skew it
+    float spentPrimitives = totalBudget - primitiveBudget;
+    if (spentPrimitives >= 1000.0f) {
+        usPerPrimitive = usPerPrimitive * 0.9f + (renderTime / spentPrimitives) * 0.1f;
+    }
+
+    // Adaptive range: shrink quickly while over budget, grow back slowly once well under it
+    budgetWindowTime += renderTime;
+    budgetWindowFrames++;
+    long long nowMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    if (adaptiveRange && nowMs - lastRangeAdjust >= 250) {
+        float avgMs = budgetWindowTime / (float)budgetWindowFrames / 1000.0f;
+        if (avgMs > frameBudgetMs) {
+            effectiveRange = (std::max)(16.0f, effectiveRange * 0.85f);
+        } else if (avgMs < frameBudgetMs * 0.6f && skippedSections == 0) {
+            effectiveRange = (std::min)((float)renderRange, effectiveRange + 8.0f);
+        }
+        lastRangeAdjust = nowMs;
+        budgetWindowTime = 0;
+        budgetWindowFrames = 0;
+    }
+
+    // HUD: say what the budget cost, only when it cost something
+    if (edgeOnlySections > 0 || markerSections > 0 || skippedSections > 0 || effectiveRange < renderRange) {
+        char hud[160];
+        snprintf(hud, sizeof(hud), "BlockESP: range %d/%d | %d edges only, %d markers, %d skipped",
+                 (int)effectiveRange, renderRange, edgeOnlySections, markerSections, skippedSections);
+        draw->AddText(ImVec2(10, screenH - 24), IM_COL32(255, 200, 80, 220), hud);
+    }
     
     // Debug Output (Throttled)
     static long long lastPrint = 0;
     long long now = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
     if (now - lastPrint > 1000) {
-        // Calculate memory
-        size_t totalBlocks = 0;
-        size_t blockMem = 0;
-        size_t edgeMem = 0;
-        size_t faceMem = 0;
-        
-        for(const auto& [key, chunk] : chunkMap) {
-            std::lock_guard<std::mutex> lock(chunk.blockMutex);
-            totalBlocks += chunk.blocks.size();
-            blockMem += chunk.blocks.size() * 48; 
-            if (chunk.mesh) {
-                edgeMem += chunk.mesh->edges.capacity() * sizeof(std::pair<ImU32, Edge>);
-                faceMem += chunk.mesh->faces.capacity() * sizeof(std::pair<ImU32, Face>);
-            }
-        }
-        
-        double blockMemMB = blockMem / (1024.0 * 1024.0);
-        double edgeMemMB = edgeMem / (1024.0 * 1024.0);
-        double faceMemMB = faceMem / (1024.0 * 1024.0);
-        double totalMemMB = blockMemMB + edgeMemMB + faceMemMB;
+        // Measured heap (MemTrack), what the budget is held to
+        const MemTagStats& heap = MemTrack::Stats(MemTag::BlockESP);
+        double heapMB = heap.liveBytes.load(std::memory_order_relaxed) / (1024.0 * 1024.0);
+        double heapPeakMB = heap.peakBytes.load(std::memory_order_relaxed) / (1024.0 * 1024.0);
+        // Cache share from the snapshot stats (per-section accounting, see SectionBytes)
+        double cacheMemMB = snapshot->cacheBytes / (1024.0 * 1024.0);
+        double meshMemMB = snapshot->meshBytes / (1024.0 * 1024.0);
+        int budgetLimit = budgetRange.load(std::memory_order_relaxed);
 
         std::cout << "[BlockESP] Render: " << renderTime << "us | Edges: " << drawnEdges 
-                  << " | Chunks: " << chunkMap.size() 
-                  << " | Blocks: " << totalBlocks
-                  << " | ESP Data: " << totalMemMB << "MB" << std::endl;
+                  << " | Sections: " << renderList.size() << " drawn, " << culledSections << " culled"
+                  << " (" << edgeOnlySections << " edges, " << markerSections << " markers, " << skippedSections << " skipped)"
+                  << " | Verts: " << projectedVerts << " (" << projectTime / 1000 << "us)"
+                  << " | Veins: " << farVeins << "/" << snapshot->clusterCount << " far"
+                  << " | Chunks: " << snapshot->chunkCount 
+                  << " | Blocks: " << snapshot->blockCount
+                  << " | ESP Data: " << heapMB << "/" << memoryBudgetMB << "MB (peak " << heapPeakMB << "MB; cache " << cacheMemMB << "MB, meshes " << meshMemMB << "MB, " << evictedColumns.size() << " columns evicted"
+                  << (budgetLimit != 0 ? ", range capped at " + std::to_string(budgetLimit) : std::string()) << ")"
+                  << " | Queue: " << workerRing.Size() << " (+" << pendingBatch.updates.size() << " pending, " << droppedUpdates << " dropped)" << std::endl;
         lastPrint = now;
     }
 }
@@ -3,6 +3,7 @@
 #include "../Module.h"
 #include "../TextureManager.h"
 #include "../MathUtils.h"
+#include "../utils/SpscRing.h"
 #include <map>
 #include <vector>
 #include <string>
@@ -16,6 +17,32 @@
 #include <queue>
 #include <memory>
 #include <atomic>
+#include <unordered_set>
+#include <unordered_map>
+#include <set>
+#include <chrono>
+
+// Hash for section keys (cx, cy, cz) so dirty/needed sets can be unordered
+struct SectionPosHash {
+    size_t operator()(const std::tuple<int, int, int>& p) const {
+        // 21 bits per axis is plenty for section coordinates
+        uint64_t h = ((uint64_t)(std::get<0>(p) & 0x1FFFFF) << 42) |
+                     ((uint64_t)(std::get<1>(p) & 0x1FFFFF) << 21) |
+                     ((uint64_t)(std::get<2>(p) & 0x1FFFFF));
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        return (size_t)h;
+    }
+};
+using SectionSet = std::unordered_set<std::tuple<int, int, int>, SectionPosHash>;
+
+// Hash for (cx, cy, cz, palette ID): one block type within a section
+struct SectionTypeHash {
+    size_t operator()(const std::tuple<int, int, int, uint16_t>& p) const {
+        return SectionPosHash()({ std::get<0>(p), std::get<1>(p), std::get<2>(p) }) ^ ((size_t)std::get<3>(p) * 0x9E3779B97F4A7C15ULL);
+    }
+};
 
 struct BlockConfig {
     bool enabled = false;
@@ -23,21 +50,150 @@ struct BlockConfig {
     bool colorInitialized = false;
 };
 
-struct Edge {
-    float x1, y1, z1;
-    float x2, y2, z2;
+// Mesh primitives are packed, section-relative and 8 bytes each.
+// Coordinates are lattice positions inside the section (0-16, 5 bits), so they stay
+// exact at any distance from the world origin. Decode*() turns them back into
+// section-local floats; the renderer adds the section origin relative to the camera.
+// Colours are not baked in: primitives carry the block's palette ID and the renderer
+// looks it up in BlockESP::paletteColors.
+struct PackedFace {
+    uint32_t bits;     // x:5 | y:5 | z:5 | w-1:4 | h-1:4 | dir:3  (x,y,z = min corner)
+    uint16_t color;    // Palette ID
+    uint16_t reserved;
 };
 
-struct Face {
-    float x1, y1, z1;
-    float x2, y2, z2;
-    float x3, y3, z3;
-    float x4, y4, z4;
+struct PackedEdge {
+    uint32_t bits;     // x:5 | y:5 | z:5 | len-1:4 | axis:2  (x,y,z = start, axis 0=X 1=Y 2=Z)
+    uint16_t color;    // Palette ID
+    uint16_t reserved;
+};
+
+static_assert(sizeof(PackedFace) == 8, "PackedFace must stay 8 bytes");
+static_assert(sizeof(PackedEdge) == 8, "PackedEdge must stay 8 bytes");
+
+// Face directions: 0: -Z (North), 1: +X (East), 2: +Z (South), 3: -X (West), 4: +Y (Up), 5: -Y (Down)
+// w runs along U and h along V: Z faces U=X V=Y | X faces U=Z V=Y | Y faces U=X V=Z
+inline PackedFace PackFace(int x, int y, int z, int w, int h, int dir, uint16_t color) {
+    PackedFace f;
+    f.bits = (uint32_t)x | ((uint32_t)y << 5) | ((uint32_t)z << 10) |
+             ((uint32_t)(w - 1) << 15) | ((uint32_t)(h - 1) << 19) | ((uint32_t)dir << 23);
+    f.color = color;
+    f.reserved = 0;
+    return f;
+}
+
+inline PackedEdge PackEdge(int x, int y, int z, int len, int axis, uint16_t color) {
+    PackedEdge e;
+    e.bits = (uint32_t)x | ((uint32_t)y << 5) | ((uint32_t)z << 10) |
+             ((uint32_t)(len - 1) << 15) | ((uint32_t)axis << 19);
+    e.color = color;
+    e.reserved = 0;
+    return e;
+}
+
+// Section-local corners in drawing order
+inline void DecodeFace(const PackedFace& f, Vec3 out[4]) {
+    float x1 = (float)(f.bits & 31);
+    float y1 = (float)((f.bits >> 5) & 31);
+    float z1 = (float)((f.bits >> 10) & 31);
+    float w = (float)(((f.bits >> 15) & 15) + 1);
+    float h = (float)(((f.bits >> 19) & 15) + 1);
+    int dir = (int)((f.bits >> 23) & 7);
+
+    switch (dir) {
+        case 0: // -Z (North)
+            out[0] = { x1 + w, y1, z1 }; out[1] = { x1, y1, z1 };
+            out[2] = { x1, y1 + h, z1 }; out[3] = { x1 + w, y1 + h, z1 };
+            break;
+        case 2: // +Z (South)
+            out[0] = { x1, y1, z1 }; out[1] = { x1 + w, y1, z1 };
+            out[2] = { x1 + w, y1 + h, z1 }; out[3] = { x1, y1 + h, z1 };
+            break;
+        case 3: // -X (West)
+            out[0] = { x1, y1, z1 }; out[1] = { x1, y1, z1 + w };
+            out[2] = { x1, y1 + h, z1 + w }; out[3] = { x1, y1 + h, z1 };
+            break;
+        case 1: // +X (East)
+            out[0] = { x1, y1, z1 + w }; out[1] = { x1, y1, z1 };
+            out[2] = { x1, y1 + h, z1 }; out[3] = { x1, y1 + h, z1 + w };
+            break;
+        case 5: // -Y (Down)
+            out[0] = { x1, y1, z1 }; out[1] = { x1 + w, y1, z1 };
+            out[2] = { x1 + w, y1, z1 + h }; out[3] = { x1, y1, z1 + h };
+            break;
+        default: // +Y (Up)
+            out[0] = { x1, y1, z1 + h }; out[1] = { x1 + w, y1, z1 + h };
+            out[2] = { x1 + w, y1, z1 }; out[3] = { x1, y1, z1 };
+            break;
+    }
+}
+
+inline void DecodeEdge(const PackedEdge& e, Vec3 out[2]) {
+    float x = (float)(e.bits & 31);
+    float y = (float)((e.bits >> 5) & 31);
+    float z = (float)((e.bits >> 10) & 31);
+    float len = (float)(((e.bits >> 15) & 15) + 1);
+    int axis = (int)((e.bits >> 19) & 3);
+
+    out[0] = { x, y, z };
+    out[1] = { axis == 0 ? x + len : x, axis == 1 ? y + len : y, axis == 2 ? z + len : z };
+}
+
+// Far-field LOD records, built with the mesh from the section's own voxels.
+// A box is the AABB of one vein (26-connected voxels of one type), drawn as an outline.
+// A dot stands in for all voxels of one type in the section, at their centroid.
+struct PackedBox {
+    uint32_t bits;     // x:4 | y:4 | z:4 | w-1:4 | h-1:4 | d-1:4  (min voxel, size in voxels)
+    uint16_t color;    // Palette ID
+    uint16_t voxels;
+};
+
+struct PackedDot {
+    uint32_t bits;     // x:6 | y:6 | z:6  (centroid in half blocks, 0-32)
+    uint16_t color;    // Palette ID
+    uint16_t voxels;
+};
+
+static_assert(sizeof(PackedBox) == 8, "PackedBox must stay 8 bytes");
+static_assert(sizeof(PackedDot) == 8, "PackedDot must stay 8 bytes");
+
+inline PackedBox PackBox(int x, int y, int z, int w, int h, int d, uint16_t color, int voxels) {
+    PackedBox b;
+    b.bits = (uint32_t)x | ((uint32_t)y << 4) | ((uint32_t)z << 8) |
+             ((uint32_t)(w - 1) << 12) | ((uint32_t)(h - 1) << 16) | ((uint32_t)(d - 1) << 20);
+    b.color = color;
+    b.voxels = (uint16_t)voxels;
+    return b;
+}
+
+// Section-local min and max corners
+inline void DecodeBox(const PackedBox& b, Vec3& outMin, Vec3& outMax) {
+    float x = (float)(b.bits & 15), y = (float)((b.bits >> 4) & 15), z = (float)((b.bits >> 8) & 15);
+    outMin = { x, y, z };
+    outMax = { x + ((b.bits >> 12) & 15) + 1, y + ((b.bits >> 16) & 15) + 1, z + ((b.bits >> 20) & 15) + 1 };
+}
+
+inline Vec3 DecodeDot(const PackedDot& d) {
+    return { (d.bits & 63) * 0.5f, ((d.bits >> 6) & 63) * 0.5f, ((d.bits >> 12) & 63) * 0.5f };
+}
+
+// Draw-time colour of a palette ID. Recolouring or hiding a block type is a
+// single table write instead of a mesh rebuild.
+struct PaletteColor {
+    ImU32 edge = 0;
+    ImU32 face = 0;
+    bool visible = false;
 };
 
 struct ChunkMesh {
-    std::vector<std::pair<ImU32, Edge>> edges;
-    std::vector<std::pair<ImU32, Face>> faces;
+    int originX = 0, originY = 0, originZ = 0; // Section origin in blocks
+    uint8_t boundsMin[3] = { 16, 16, 16 };     // Section-local AABB of all primitives
+    uint8_t boundsMax[3] = { 0, 0, 0 };
+    std::vector<PackedEdge> edges;
+    std::vector<PackedFace> faces;
+    std::vector<PackedBox> boxes; // LOD 1: vein outlines
+    std::vector<PackedDot> dots;  // LOD 2: one per palette ID
+    mutable std::atomic<long long> lastVisibleMs{0}; // Set by Render when the section passes culling
 };
 
 struct CachedChunk {
@@ -45,8 +201,8 @@ struct CachedChunk {
     // 0 is reserved for "Air/Unknown"
     std::map<int, uint16_t> blocks; // Local Index (0-4095) -> PaletteID
     
-    std::shared_ptr<ChunkMesh> mesh;
-    mutable std::mutex meshMutex; // Protects access to mesh pointer
+    std::shared_ptr<const ChunkMesh> mesh; // Replaced, never modified, once built (Worker thread only)
+    size_t bytes = 0;              // Heap held by the section as of its last mesh build (Worker)
     mutable std::mutex blockMutex; // Protects access to blocks map
     
     CachedChunk() : mesh(std::make_shared<ChunkMesh>()) {}
@@ -54,10 +210,83 @@ struct CachedChunk {
         // Copy constructor needed for std::map insertion
         blocks = other.blocks;
         mesh = other.mesh;
+        bytes = other.bytes;
         // mutex cannot be copied, so we initialize a new one
     }
 };
 
+// A whole vein: the section-local vein boxes of one type that touch across section borders.
+// Kept up to date by the worker as sections are re-meshed; coordinates are world blocks.
+struct VeinCluster {
+    int minX, minY, minZ;             // Inclusive
+    int maxX, maxY, maxZ;             // Exclusive
+    double centerX, centerY, centerZ; // Centroid (box centres weighted by voxel count)
+    uint32_t voxels;
+    uint16_t color;                   // Palette ID
+};
+
+// Immutable view of every non-empty section mesh, published by the worker after each batch.
+// Render takes the current one with an atomic load and never touches chunkMap. Snapshots
+// and the meshes they point to are freed when the last holder (worker or frame) drops them.
+struct RenderSnapshot {
+    struct Section {
+        int cx, cy, cz;                  // Section coordinates
+        float centerX, centerY, centerZ; // AABB centre relative to the section origin
+        float halfX, halfY, halfZ;       // AABB half extents, for frustum culling
+        std::shared_ptr<const ChunkMesh> mesh;
+    };
+    std::vector<Section> sections;  // Far -> near as seen from the sort section below
+    int sortCx = 0, sortCy = 0, sortCz = 0;
+
+    // Section-granular distance used for draw ordering. Only changes when the camera
+    // crosses a section boundary, so the order can be reused between frames. Capped (and
+    // computed wide, so far-away coordinates cannot overflow): sections that far are out of
+    // range anyway and share the farthest bucket of the counting sort.
+    static constexpr int kOrderKeyCap = 0xFFFF;
+    static int OrderKey(const Section& s, int camCx, int camCy, int camCz) {
+        int64_t dx = (int64_t)s.cx - camCx, dy = (int64_t)s.cy - camCy, dz = (int64_t)s.cz - camCz;
+        return (int)(std::min)(dx * dx + dy * dy + dz * dz, (int64_t)kOrderKeyCap);
+    }
+
+    // Veins, bucketed by the grid cell of their centroid. Cells are immutable and shared with
+    // the previous snapshot unless a vein in them changed.
+    static constexpr int kClusterCell = 64; // Blocks per grid cell edge
+    using ClusterCell = std::vector<VeinCluster>;
+    std::unordered_map<std::tuple<int, int, int>, std::shared_ptr<const ClusterCell>, SectionPosHash> clusterGrid;
+    size_t clusterCount = 0;
+    int gridMin[3] = { 0, 0, 0 }, gridMax[3] = { 0, 0, 0 }; // Occupied cell range
+
+    // Cache stats for the debug output
+    size_t chunkCount = 0;
+    size_t blockCount = 0;
+    size_t meshBytes = 0;
+    size_t cacheBytes = 0; // Everything the cache holds, sum of CachedChunk::bytes
+};
+
+// Detail a section is drawn with under the frame budget, best first
+enum DrawLevel : uint8_t { DrawFull, DrawEdges, DrawMarker, DrawSkip };
+
+// Geometry a section is drawn from, picked by the projected size of one block
+enum MeshLod : uint8_t { LodMesh, LodBoxes, LodDots };
+
+// One hand-off of cache work from the render thread to the worker, applied in this order:
+// world switch, clear, unloads, updates, type removals. Usually one frame's worth.
+struct WorkerBatch {
+    bool switchWorld = false;                 // Save the cache to its world file, clear, then load worldFile
+    std::string worldFile;                    // Empty: detach (save and clear only)
+    bool clearFirst = false;                  // Drop the whole cache (and everything queued before)
+    bool sendManifest = false;                // Hash the cache's columns afterwards for a resync
+    std::vector<std::pair<int, int>> unloads; // Chunk columns (cx, cz)
+    std::vector<BlockUpdate> updates;
+    std::vector<SectionBlocks> sections;      // Bulk adds, applied before updates
+    std::vector<std::pair<int, int>> restored; // Evicted columns asked back from the mod: accept their data again
+    std::vector<uint16_t> typeRemovals;       // Palette IDs to drop from the cache
+    bool remeshAll = false;                   // Rebuild every section's mesh (a mesh option changed)
+    std::chrono::steady_clock::time_point queuedAt;
+
+    bool Empty() const { return !switchWorld && !clearFirst && !sendManifest && unloads.empty() && updates.empty() && sections.empty() && restored.empty() && typeRemovals.empty() && !remeshAll; }
+};
+
 class BlockESP : public Module {
 public:
     std::map<std::string, BlockConfig> blocks;
@@ -68,10 +297,13 @@ public:
     std::vector<std::string> globalPalette; // ID -> Name. Index 0 is "air"
     std::map<std::string, uint16_t> globalPaletteMap; // Name -> ID
     std::mutex paletteMutex;
+    std::vector<PaletteColor> paletteColors; // ID -> Draw colour. Main thread only
+    bool paletteColorsDirty = true;          // Rebuild every entry on next refresh
     
-    // World State
+    // World State (Worker thread; Render reads renderSnapshot instead)
     std::map<std::tuple<int, int, int>, CachedChunk> chunkMap;
     std::shared_mutex chunkMapMutex;
+    std::shared_ptr<const RenderSnapshot> renderSnapshot; // Access via std::atomic_load/store only
 
     NetworkClient* net;
     
@@ -81,45 +313,181 @@ public:
     std::string editingBlock = ""; // Which block is currently being color picked
     bool showColorPicker = false;
     int renderRange = 64;
+    float frameBudgetMs = 4.0f;   // Target BlockESP draw time per frame
+    bool adaptiveRange = true;    // Pull the range in while over budget
+    float lodMeshPx = 6.0f;       // Pixels per block at or above which the full mesh is drawn
+    float lodBoxPx = 2.0f;        // ... vein outlines; below this, one dot per block type
+    int memoryBudgetMB = 256;     // Cache size past which far columns are evicted
+    int nearestVeinCount = 5;     // Rows of the "Nearest Veins" list
+    std::atomic<bool> quadSeams{ true }; // Also outline the seams between coplanar greedy quads (read by the worker)
+
+    // Budget state (Main thread)
+    float effectiveRange = 64.0f;  // Range actually drawn, <= renderRange
+    float usPerPrimitive = 0.05f;  // Measured draw cost per face/edge
+    long long budgetWindowTime = 0;
+    int budgetWindowFrames = 0;
+    long long lastRangeAdjust = 0;
+    ProjectionBatch projection; // Render scratch, reused every frame
+    struct RenderableChunk {
+        Vec3 offset; // Section origin relative to the camera
+        Vec3 center; // AABB centre relative to the camera
+        const ChunkMesh* mesh;
+        MeshLod lod;
+        DrawLevel level;
+    };
+    std::vector<RenderableChunk> renderList; // Render scratch: this frame's sections, far -> near
+    std::unordered_set<std::tuple<int, int, int, uint16_t>, SectionTypeHash> markedTypes; // Render scratch: types a far vein marker stands for, per section
+    double viewX = 0.0, viewY = 0.0, viewZ = 0.0; // Camera position of the last frame
+
+    // Draw order (Main thread): indices into orderedSnapshot->sections, far -> near for the
+    // camera in section (orderedCx, orderedCy, orderedCz). Re-bucketed when the camera changes section.
+    std::shared_ptr<const RenderSnapshot> orderedSnapshot;
+    std::vector<uint32_t> drawOrder;
+    std::vector<int> drawOrderKeys;         // Scratch: distance key per section
+    std::vector<uint32_t> drawOrderBuckets; // Scratch: counting sort offsets
+    std::vector<uint32_t> drawOrderScratch;
+    int orderedCx = 0, orderedCy = 0, orderedCz = 0;
+    std::atomic<int> cameraCx{0}, cameraCy{0}, cameraCz{0}; // Latest camera section, for the worker's pre-sort
 
     // Worker Thread
     std::thread workerThread;
     std::atomic<bool> shouldStop{false};
-    std::mutex queueMutex;
+    SpscRing<WorkerBatch, 64> workerRing; // Render thread -> Worker, batches are moved not copied
+    WorkerBatch pendingBatch;             // Main thread: work not yet in the ring (coalesces while it is full)
+    WorkerBatch deferredBatch;            // Worker: popped but left for the next pass (a world switch)
+    bool hasDeferredBatch = false;
+    size_t droppedUpdates = 0;            // Main thread: updates discarded by the backlog limit
+    std::mutex queueMutex;                // Only for sleeping on queueCV, the ring itself is lock-free
     std::condition_variable queueCV;
-    std::queue<std::vector<BlockUpdate>> updateQueue;
-    std::queue<std::pair<int, int>> unloadQueue;
-    std::atomic<bool> clearCacheRequested{false};
+
+    // Snapshot order upkeep (Worker thread only): the next snapshot starts from the previous
+    // one's far -> near list and only revisits these sections
+    SectionSet meshChanged;  // Re-meshed or erased since the last snapshot
+    bool orderStale = true;  // Cache was cleared or replaced, rebuild the list from scratch
+
+    // Vein clusters (Worker thread only). Every section's vein boxes in world space, each
+    // labelled with its cluster; a re-meshed section relabels only the clusters it touches.
+    struct VeinBox {
+        int min[3], max[3]; // World blocks, max exclusive
+        uint16_t color;
+        uint16_t voxels;
+        uint8_t border;     // Bit 2i: touches the min face of axis i, bit 2i+1: the max face
+        uint32_t cluster;   // 0 while unlabelled
+    };
+    struct VeinClusterState {
+        VeinCluster cluster;
+        std::vector<std::tuple<int, int, int>> sections; // Sections holding its boxes
+        std::tuple<int, int, int> cell;                  // Grid cell of its centroid
+    };
+    std::unordered_map<std::tuple<int, int, int>, std::vector<VeinBox>, SectionPosHash> veinBoxes;
+    std::unordered_map<uint32_t, VeinClusterState> veinClusters;
+    std::unordered_map<std::tuple<int, int, int>, std::vector<uint32_t>, SectionPosHash> veinCells; // Cell -> cluster IDs
+    SectionSet dirtyVeinCells; // Cells to rebuild in the next snapshot
+    uint32_t nextVeinCluster = 1;
+
+    // Inverted index: Palette ID -> sections that may contain it (Worker thread only).
+    // Added on insert, dropped on unload or type removal, so it can over-report.
+    std::vector<SectionSet> typeSections;
+
+    // Persistent world cache (Worker thread; worldKey is the main thread's view)
+    std::string worldKey;   // Main thread: world the queued batches belong to
+    std::string cacheFile;  // Worker: file the current cache is saved to, empty when detached
+    bool cacheDirty = false;
+    std::chrono::steady_clock::time_point lastCacheSave;
+
+    // Memory budget, held against the BlockESP heap as MemTrack measures it. The worker evicts
+    // whole columns outside the range (least recently visible, then farthest); the main thread
+    // tells the mod to forget them and asks for them back once the camera is back within the
+    // range (less a margin, see kRestoreMargin). When the range itself doesn't fit, the worker
+    // lowers budgetRange and the subscription, keepRange and draw range follow (DataRange).
+    std::atomic<size_t> memoryBudget{ (size_t)256 << 20 };  // Bytes, from memoryBudgetMB
+    std::atomic<int> keepRange{ 64 + 24 };                  // Blocks around the camera never evicted
+    std::atomic<int> budgetRange{ 0 };                      // Blocks, set by the worker while the render range doesn't fit; 0 when not
+    std::chrono::steady_clock::time_point lastBudgetRangeChange; // Worker
+    std::set<std::pair<int, int>> workerEvicted;            // Worker: data for these is dropped
+    std::mutex evictMutex;
+    std::vector<std::pair<int, int>> newlyEvicted;          // Worker -> Main, guarded by evictMutex
+    std::set<std::pair<int, int>> evictedColumns;           // Main: forgotten by the mod, not requested back yet
+    long long lastRestoreCheck = 0;
+    static constexpr long long kRestoreMargin = 2;          // Columns between the eviction and restore radius
+
+    // Block list toggles not sent yet (Main thread), debounced so a burst of clicks is one
+    // packet. A type in both was switched off and on again: the mod drops it and scans anew.
+    std::set<std::string> pendingTypeAdds, pendingTypeRemoves;
+    long long lastTypeToggle = 0;
+
+    // Interest subscription (Main thread): what was last sent to the mod
+    bool subscriptionStale = true;
+    int subscribedRange = 0;
+    int subscribedCx = 0, subscribedCy = 0, subscribedCz = 0;
+    float subscribedYaw = 0.0f;
+    long long lastSubscription = 0;
+
+    // Resync (kept across reconnects): on connect the mod names the world, the worker hashes
+    // every cached column and the main thread sends the manifest
+    bool awaitingIdentity = true;            // Main thread: connected, world not announced yet
+    std::mutex manifestMutex;                // Guards the two below (Worker -> Main)
+    std::vector<ColumnHash> readyManifest;
+    bool manifestReady = false;
 
     BlockESP(NetworkClient* netInstance);
     ~BlockESP();
     
     void RenderSettings() override;
     void OnToggle() override;
+    void Update(const GameData* data) override; // Every frame, Render or not
     void SaveConfig(std::ostream& stream) override;
     void LoadConfig(const std::map<std::string, std::string>& config) override;
     
     void SendUpdate(); // Made public for main.cpp to call on connect
 
-    void RemoveBlocks(const std::string& blockId); // Helper to remove specific blocks
+    void RemoveBlocks(const std::string& blockId); // Queues removal of one block type from the cache
+    void ClearCache(bool resync = true); // Queues a full cache clear; resync has the mod resend its columns
+    void SwitchWorld(const std::string& key); // Queues saving this world's cache and loading key's
+
+    void Render(GameData& data, float screenW, float screenH, ImDrawList* draw);
 
-    void Render(const GameData& data, float screenW, float screenH, ImDrawList* draw);
+    // Up to count veins of blockId (any type when empty) nearest to a world position, nearest
+    // first, skipping palette IDs that are false or past the end of visible when one is given.
+    // Reads the latest snapshot, cheap enough to call every frame.
+    std::vector<VeinCluster> NearestVeins(const std::string& blockId, double x, double y, double z, size_t count,
+                                          const std::vector<bool>* visible = nullptr);
 
     
 private:
     void LoadAvailableBlocks();
-    void RebuildAllChunks();
+    void RefreshPaletteColors();
+    void UpdatePaletteColor(const std::string& blockId);
     // void SendUpdate(); // Moved to public
-    void ProcessUpdates(const std::vector<BlockUpdate>& updates, long long& outUpdateTime, long long& outRebuildTime);
+    WorkerBatch& PendingBatch();
+    void FlushPendingBatch();
+    void QueueBlockData(std::vector<BlockUpdate>& updates, std::vector<SectionBlocks>& sections, std::vector<std::pair<int, int>>& unloads);
+    void ProcessTypeRemovals(const std::vector<uint16_t>& ids);
+    void ProcessUpdates(const std::vector<BlockUpdate>& updates, const std::vector<SectionBlocks>& sections, long long& outUpdateTime, long long& outRebuildTime, int& outRebuildCount);
     
     // Internal helpers
     void UpdateChunk(std::tuple<int, int, int> chunkPos);
+    void PublishSnapshot();
+    void UpdateVeinClusters(const SectionSet& changed);
+    void SaveWorldCache(const std::string& path);
+    void BuildManifest(std::vector<ColumnHash>& out);
+    void UpdateSubscription(const GameData& data, float screenW, float screenH);
+    void FlushTypeChanges();
+    void UpdateEvictions(const GameData& data);
+    void ResetEvictions(bool askBack);
+    bool EvictOverBudget();
+    int DataRange();
+    void UnloadColumns(const std::vector<std::pair<int, int>>& columns);
+    void LoadWorldCache(const std::string& path);
+    void UpdateDrawOrder(const std::shared_ptr<const RenderSnapshot>& snapshot, int camCx, int camCy, int camCz);
     std::tuple<int, int, int> GetChunkPos(int x, int y, int z);
     
     // Palette Helpers
     uint16_t GetBlockID(const std::string& name);
     std::string GetBlockName(uint16_t id);
-    uint16_t GetBlock(int x, int y, int z); // Returns ID instead of string
 
     void WorkerLoop();
+
+    friend struct BlockESPBench; // bench/MesherBench.cpp
+    friend struct BlockESPTest;  // tests/WorkerBatchTest.cpp
 };
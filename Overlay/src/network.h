@@ -10,6 +10,7 @@
 #include <chrono>
 #include <intrin.h>
 #include "Module.h"
+#include "utils/MemTrack.h"
 
 #pragma comment(lib, "ws2_32.lib")
 
@@ -54,15 +55,37 @@ struct BlockUpdate {
     int x, y, z;
 };
 
+// Bulk adds for one 16^3 section: its block ids once, then a u16 per block,
+// (palette slot << 12) | local index (x + y * 16 + z * 256), sorted by index
+struct SectionBlocks {
+    int cx, cy, cz;
+    std::vector<std::string> palette; // At most 16 ids
+    std::vector<uint16_t> entries;
+};
+
+// Content hash of one chunk column's cached blocks, for the resync manifest
+struct ColumnHash {
+    int cx, cz;
+    uint64_t hash;
+};
+
 struct GameData {
     float camYaw, camPitch;
     double camX, camY, camZ; // Absolute Camera Position
     float fov;
+    bool hasViewProj = false;    // viewProj valid for this frame
+    float viewProj[16] = {};     // Game projection * view rotation, column-major, camera-relative
     bool isScreenOpen;
     int targetedEntityId = -1;
     bool shouldClearBlocks = false;
+    std::string worldKey;        // Server/world|dimension the block data belongs to (kept between frames)
+    bool worldSplit = false;     // A world identity arrived this frame; the block data before it
+    size_t splitUpdates = 0;     // (these many of each list) belongs to the previous world
+    size_t splitSections = 0;
+    size_t splitUnloads = 0;
     std::vector<Entity> entities;
     std::vector<BlockUpdate> blockUpdates;
+    std::vector<SectionBlocks> sectionBlocks;
     std::vector<std::string> blocksToDelete;
     std::vector<std::pair<int, int>> chunksToUnload;
     std::vector<int> hotkeysPressed;
@@ -190,6 +213,26 @@ public:
         return true;
     }
 
+    // Block list changes since the last full list (0xB10C0). The mod applies removes first, so a
+    // type in both lists is dropped and scanned for again.
+    bool SendBlockListDiff(const std::vector<std::string>& added, const std::vector<std::string>& removed) {
+        if (!connected) return false;
+        std::cout << "[Overlay] Sending Block List Diff. Added: " << added.size() << ", Removed: " << removed.size() << std::endl;
+        int header = htonl(0xB10CD1F);
+        if (send(sock, (char*)&header, 4, 0) == SOCKET_ERROR) return false;
+
+        for (const auto* list : { &removed, &added }) {
+            int count = htonl(list->size());
+            if (send(sock, (char*)&count, 4, 0) == SOCKET_ERROR) return false;
+            for (const auto& block : *list) {
+                int len = htonl(block.length());
+                if (send(sock, (char*)&len, 4, 0) == SOCKET_ERROR) return false;
+                if (send(sock, block.c_str(), block.length(), 0) == SOCKET_ERROR) return false;
+            }
+        }
+        return true;
+    }
+
     bool SendESPSettings(bool showGeneric, bool showAll, const std::map<std::string, std::vector<float>>& specificMobs) {
         if (!connected) return false;
         
@@ -211,6 +254,93 @@ public:
         return true;
     }
 
+    // Columns BlockESP draws: range in blocks around the camera section, optionally with the
+    // horizontal view cone. The mod scans and streams only these, nearest (and in view) first.
+    bool SendSubscription(int range, int cx, int cy, int cz, bool hasFrustum, float yaw, float halfFov) {
+        if (!connected) return false;
+
+        char buffer[4 * 5 + 1 + 4 * 2];
+        auto putInt = [&](size_t at, int value) {
+            int n = htonl(value);
+            memcpy(&buffer[at], &n, 4);
+        };
+        auto putFloat = [&](size_t at, float value) {
+            int bits;
+            memcpy(&bits, &value, 4);
+            putInt(at, bits);
+        };
+        putInt(0, 0x5B5C0);
+        putInt(4, range);
+        putInt(8, cx);
+        putInt(12, cy);
+        putInt(16, cz);
+        buffer[20] = hasFrustum ? 1 : 0;
+        int size = 21;
+        if (hasFrustum) {
+            putFloat(21, yaw);
+            putFloat(25, halfFov);
+            size = 29;
+        }
+        return send(sock, buffer, size, 0) != SOCKET_ERROR;
+    }
+
+    // Chunk columns for a BlockESP column message: 0xE71C7 evicted (forget them), 0xE71C8
+    // back in range (scan and send them again)
+    bool SendColumnList(int header, const std::vector<std::pair<int, int>>& columns) {
+        if (!connected) return false;
+
+        std::vector<char> buffer(8 + columns.size() * 8);
+        auto putInt = [&](size_t at, int value) {
+            int n = htonl(value);
+            memcpy(&buffer[at], &n, 4);
+        };
+        putInt(0, header);
+        putInt(4, (int)columns.size());
+        for (size_t i = 0; i < columns.size(); i++) {
+            putInt(8 + i * 8, columns[i].first);
+            putInt(12 + i * 8, columns[i].second);
+        }
+
+        size_t sent = 0;
+        while (sent < buffer.size()) {
+            int r = send(sock, buffer.data() + sent, (int)(buffer.size() - sent), 0);
+            if (r == SOCKET_ERROR) return false;
+            sent += r;
+        }
+        return true;
+    }
+
+    // Column hashes of the overlay's cache; the mod answers with the columns that differ.
+    // Built into one buffer and sent at once, a manifest can list thousands of columns.
+    bool SendManifest(const std::vector<ColumnHash>& columns) {
+        if (!connected) return false;
+
+        std::vector<char> buffer(8 + columns.size() * 16);
+        auto putInt = [&](size_t at, int value) {
+            int n = htonl(value);
+            memcpy(&buffer[at], &n, 4);
+        };
+        putInt(0, 0xC01A5C);
+        putInt(4, (int)columns.size());
+        size_t at = 8;
+        for (const auto& column : columns) {
+            putInt(at, column.cx);
+            putInt(at + 4, column.cz);
+            uint64_t hash = _byteswap_uint64(column.hash);
+            memcpy(&buffer[at + 8], &hash, 8);
+            at += 16;
+        }
+
+        size_t sent = 0;
+        while (sent < buffer.size()) {
+            int r = send(sock, buffer.data() + sent, (int)(buffer.size() - sent), 0);
+            if (r == SOCKET_ERROR) return false;
+            sent += r;
+        }
+        std::cout << "[Overlay] Sent cache manifest. Columns: " << columns.size() << std::endl;
+        return true;
+    }
+
     int VKToGLFW(int vk) {
         if (vk >= '0' && vk <= '9') return vk;
         if (vk >= 'A' && vk <= 'Z') return vk;
@@ -389,6 +519,13 @@ public:
                 readDouble(data.camZ);
                 readFloat(data.fov);
 
+                char hasMatrix;
+                readByte(hasMatrix);
+                data.hasViewProj = (hasMatrix != 0);
+                if (data.hasViewProj) {
+                    for (int i = 0; i < 16; i++) readFloat(data.viewProj[i]);
+                }
+
                 char screenStatus;
                 readByte(screenStatus);
                 data.isScreenOpen = (screenStatus != 0);
@@ -403,6 +540,7 @@ public:
                 }
 
                 if (!readError) {
+                    MemScope memScope(MemTag::EntityCache);
                     data.entities.clear();
                     data.entities.reserve(count); // Phase 2: Reserve Space
                     currentFrame++;
@@ -561,6 +699,41 @@ public:
                         }
                     }
                 }
+                else if (header == 0x5EC7B10) { // Section Blocks (bulk adds)
+                    SectionBlocks section;
+                    readInt(section.cx); readInt(section.cy); readInt(section.cz);
+                    int paletteCount;
+                    readInt(paletteCount);
+                    if (!readError && (paletteCount < 1 || paletteCount > 16)) {
+                        std::cout << "[Network] Error: Section palette size " << paletteCount << " out of bounds." << std::endl;
+                        readError = true;
+                    }
+                    if (!readError) {
+                        section.palette.resize(paletteCount);
+                        for (auto& id : section.palette) readString(id);
+                    }
+                    int count;
+                    readInt(count);
+                    if (!readError && (count < 0 || count > 4096)) {
+                        std::cout << "[Network] Error: Section block count " << count << " out of bounds." << std::endl;
+                        readError = true;
+                    }
+                    if (!readError) {
+                        // One read for all entries instead of a recv per block
+                        section.entries.resize(count);
+                        char* dst = (char*)section.entries.data();
+                        int total = 0;
+                        while (total < count * 2) {
+                            int rr = recv(sock, dst + total, count * 2 - total, 0);
+                            if (rr <= 0) { readError = true; break; }
+                            total += rr;
+                        }
+                        for (auto& e : section.entries) e = ntohs(e);
+                    }
+                    if (!readError) {
+                        data.sectionBlocks.push_back(std::move(section));
+                    }
+                }
                 else if (header == 0x0C1EA400) { // CLEAR ALL
                     data.shouldClearBlocks = true;
                 }
@@ -576,9 +749,35 @@ public:
                     readInt(cx);
                     readInt(cz);
                     if (!readError) {
+                        // Unloads are applied ahead of the frame's updates: drop what this column
+                        // got earlier in the frame (in the current world) so it isn't re-added
+                        auto updatesFrom = data.blockUpdates.begin() + (data.worldSplit ? data.splitUpdates : 0);
+                        data.blockUpdates.erase(std::remove_if(updatesFrom, data.blockUpdates.end(),
+                            [&](const BlockUpdate& u) { return (u.x >> 4) == cx && (u.z >> 4) == cz; }), data.blockUpdates.end());
+                        auto sectionsFrom = data.sectionBlocks.begin() + (data.worldSplit ? data.splitSections : 0);
+                        data.sectionBlocks.erase(std::remove_if(sectionsFrom, data.sectionBlocks.end(),
+                            [&](const SectionBlocks& s) { return s.cx == cx && s.cz == cz; }), data.sectionBlocks.end());
                         data.chunksToUnload.push_back({cx, cz});
                     }
                 }
+                else if (header == 0x3071D0) { // World Identity
+                    std::string key;
+                    readString(key);
+                    if (!readError) {
+                        // A second change within the frame: what came since the first belongs
+                        // to a world already left
+                        if (data.worldSplit) {
+                            data.blockUpdates.resize(data.splitUpdates);
+                            data.sectionBlocks.resize(data.splitSections);
+                            data.chunksToUnload.resize(data.splitUnloads);
+                        }
+                        data.worldSplit = true;
+                        data.splitUpdates = data.blockUpdates.size();
+                        data.splitSections = data.sectionBlocks.size();
+                        data.splitUnloads = data.chunksToUnload.size();
+                        data.worldKey = key;
+                    }
+                }
                 else if (header == 0xCB14D) { // Hotkey Pressed
                     int key;
                     readInt(key);
@@ -1,5 +1,6 @@
 #include "IconLoader.h"
 #include "../stb_image.h"
+#include "MemTrack.h"
 #include <algorithm>
 #include <iostream>
 
@@ -11,6 +12,7 @@ IconLoader& IconLoader::Get() {
 }
 
 void IconLoader::Initialize(ID3D11Device* dev) {
+    MemScope memScope(MemTag::Textures);
     this->device = dev;
     availableIcons.clear();
     
@@ -49,6 +51,7 @@ void IconLoader::Initialize(ID3D11Device* dev) {
 
 ID3D11ShaderResourceView* IconLoader::GetTexture(const std::string& name) {
     if (textureCache.count(name)) return textureCache[name];
+    MemScope memScope(MemTag::Textures);
 
     // Try loading from Item folder first
     std::string itemPath = "C:/Users/Tobi/Documents/GitHub/XaiClient2.0.0/Overlay/assets/MinecraftTexturePack/assets/minecraft/textures/item/" + name + ".png";
@@ -115,6 +118,8 @@ ID3D11ShaderResourceView* IconLoader::LoadTextureFromFile(const std::string& pat
     device->CreateShaderResourceView(pTexture, nullptr, &pSRV);
     pTexture->Release();
 
+    if (pSRV) MemTrack::AddGpuBytes(MemTag::Textures, (int64_t)w * h * 4);
+
     return pSRV;
 }
 
@@ -0,0 +1,124 @@
+#include "MemTrack.h"
+#include <cstdlib>
+#include <new>
+
+namespace {
+    // Kept at 16 bytes so the pointer handed out keeps malloc's alignment
+    struct alignas(16) BlockHeader {
+        uint64_t size;
+        MemTag tag;
+    };
+    static_assert(sizeof(BlockHeader) == 16, "MemTrack header must preserve 16-byte alignment");
+
+    MemTagStats g_stats[(int)MemTag::Count];
+    thread_local MemTag t_currentTag = MemTag::Other;
+    thread_local int64_t t_netBytes = 0;
+
+    void Charge(MemTag tag, size_t size) {
+        MemTagStats& s = g_stats[(int)tag];
+        int64_t live = s.liveBytes.fetch_add((int64_t)size, std::memory_order_relaxed) + (int64_t)size;
+        int64_t peak = s.peakBytes.load(std::memory_order_relaxed);
+        while (live > peak && !s.peakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+        s.allocs.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void Release(MemTag tag, size_t size) {
+        MemTagStats& s = g_stats[(int)tag];
+        s.liveBytes.fetch_sub((int64_t)size, std::memory_order_relaxed);
+        s.frees.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+namespace MemTrack {
+    MemTagStats& Stats(MemTag tag) { return g_stats[(int)tag]; }
+
+    const char* Name(MemTag tag) {
+        switch (tag) {
+            case MemTag::BlockESP: return "BlockESP";
+            case MemTag::EntityCache: return "Entities";
+            case MemTag::Textures: return "Textures";
+            case MemTag::ImGui: return "ImGui";
+            default: return "Other";
+        }
+    }
+
+    MemTag Current() { return t_currentTag; }
+    int64_t ThreadNetBytes() { return t_netBytes; }
+    void SetCurrent(MemTag tag) { t_currentTag = tag; }
+
+    void* Alloc(size_t size, MemTag tag) {
+        BlockHeader* h = (BlockHeader*)malloc(sizeof(BlockHeader) + size);
+        if (!h) return nullptr;
+        h->size = size;
+        h->tag = tag;
+        Charge(tag, size);
+        t_netBytes += (int64_t)size;
+        return h + 1;
+    }
+
+    void* Realloc(void* ptr, size_t size, MemTag tag) {
+        if (!ptr) return Alloc(size, tag);
+        BlockHeader* h = (BlockHeader*)ptr - 1;
+        MemTag oldTag = h->tag;
+        size_t oldSize = (size_t)h->size;
+
+        BlockHeader* n = (BlockHeader*)realloc(h, sizeof(BlockHeader) + size);
+        if (!n) return nullptr; // Original block is untouched and still charged
+        Release(oldTag, oldSize);
+        n->size = size;
+        n->tag = tag;
+        Charge(tag, size);
+        t_netBytes += (int64_t)size - (int64_t)oldSize;
+        return n + 1;
+    }
+
+    void Free(void* ptr) {
+        if (!ptr) return;
+        BlockHeader* h = (BlockHeader*)ptr - 1;
+        Release(h->tag, (size_t)h->size);
+        t_netBytes -= (int64_t)h->size;
+        free(h);
+    }
+
+    void AddGpuBytes(MemTag tag, int64_t bytes) {
+        g_stats[(int)tag].gpuBytes.fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+    void* ImGuiAlloc(size_t size, void*) { return Alloc(size, MemTag::ImGui); }
+    void ImGuiFree(void* ptr, void*) { Free(ptr); }
+
+    Snapshot Capture() {
+        Snapshot snap;
+        for (int i = 0; i < (int)MemTag::Count; i++) {
+            snap.liveBytes[i] = g_stats[i].liveBytes.load(std::memory_order_relaxed);
+            snap.peakBytes[i] = g_stats[i].peakBytes.load(std::memory_order_relaxed);
+            snap.allocs[i] = g_stats[i].allocs.load(std::memory_order_relaxed);
+            snap.gpuBytes[i] = g_stats[i].gpuBytes.load(std::memory_order_relaxed);
+        }
+        return snap;
+    }
+}
+
+// Global allocation hooks. Over-aligned (std::align_val_t) allocations keep the runtime's own
+// operators and are not tracked; nothing in the overlay uses them on a hot path.
+void* operator new(size_t size) {
+    void* p = MemTrack::Alloc(size, t_currentTag);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](size_t size) {
+    void* p = MemTrack::Alloc(size, t_currentTag);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return MemTrack::Alloc(size, t_currentTag); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return MemTrack::Alloc(size, t_currentTag); }
+
+void operator delete(void* ptr) noexcept { MemTrack::Free(ptr); }
+void operator delete[](void* ptr) noexcept { MemTrack::Free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { MemTrack::Free(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { MemTrack::Free(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { MemTrack::Free(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { MemTrack::Free(ptr); }
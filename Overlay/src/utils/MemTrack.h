@@ -0,0 +1,70 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Per-subsystem heap accounting.
+// Every global operator new / delete goes through MemTrack (see MemTrack.cpp). Each block carries
+// a small header with its tag and size, so a free is charged to the subsystem that allocated it
+// no matter which thread releases it. The tag of new allocations is the calling thread's current
+// scope (MemScope); anything outside a scope lands in Other.
+enum class MemTag : uint8_t {
+    Other,
+    BlockESP,
+    EntityCache,
+    Textures,
+    ImGui,
+    Count
+};
+
+struct MemTagStats {
+    std::atomic<int64_t> liveBytes{ 0 };
+    std::atomic<int64_t> peakBytes{ 0 };
+    std::atomic<uint64_t> allocs{ 0 };   // Lifetime totals; diff two snapshots for a per-frame rate
+    std::atomic<uint64_t> frees{ 0 };
+    std::atomic<int64_t> gpuBytes{ 0 };  // Device memory that never touches the heap (texture uploads)
+};
+
+namespace MemTrack {
+    MemTagStats& Stats(MemTag tag);
+    const char* Name(MemTag tag);
+
+    MemTag Current();
+    void SetCurrent(MemTag tag);
+
+    void* Alloc(size_t size, MemTag tag);
+    void* Realloc(void* ptr, size_t size, MemTag tag);
+    void Free(void* ptr);
+
+    // Heap bytes allocated minus freed by the calling thread, any tag. The difference across a
+    // piece of code is what it left allocated (when nothing else on the thread frees meanwhile).
+    int64_t ThreadNetBytes();
+
+    // Charges memory owned outside the heap (e.g. a D3D texture) to a tag
+    void AddGpuBytes(MemTag tag, int64_t bytes);
+
+    // ImGui::SetAllocatorFunctions hooks, tagged ImGui regardless of the current scope
+    void* ImGuiAlloc(size_t size, void* userData);
+    void ImGuiFree(void* ptr, void* userData);
+
+    // Point-in-time copy of the counters, used for per-frame allocation deltas
+    struct Snapshot {
+        int64_t liveBytes[(int)MemTag::Count];
+        int64_t peakBytes[(int)MemTag::Count];
+        uint64_t allocs[(int)MemTag::Count];
+        int64_t gpuBytes[(int)MemTag::Count];
+    };
+    Snapshot Capture();
+}
+
+// Tags allocations made by this thread until the scope ends. Nests: the previous tag is restored.
+class MemScope {
+public:
+    explicit MemScope(MemTag tag) : previous(MemTrack::Current()) { MemTrack::SetCurrent(tag); }
+    ~MemScope() { MemTrack::SetCurrent(previous); }
+    MemScope(const MemScope&) = delete;
+    MemScope& operator=(const MemScope&) = delete;
+
+private:
+    MemTag previous;
+};
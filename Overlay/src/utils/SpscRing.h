@@ -0,0 +1,52 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+// Bounded single-producer / single-consumer ring.
+// One thread calls TryPush, one other thread calls TryPop; neither ever blocks or locks.
+// Elements are moved in and out, so a slot holding a std::vector hands its buffer over
+// without copying. Capacity must be a power of two.
+template <typename T, size_t Capacity>
+class SpscRing {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "SpscRing capacity must be a power of two");
+
+public:
+    // Producer only. Returns false (and leaves value untouched) when the ring is full.
+    bool TryPush(T&& value) {
+        size_t tail = tailIndex.load(std::memory_order_relaxed);
+        if (tail - headIndex.load(std::memory_order_acquire) >= Capacity) return false;
+
+        slots[tail & (Capacity - 1)] = std::move(value);
+        tailIndex.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only. Returns false when the ring is empty.
+    bool TryPop(T& out) {
+        size_t head = headIndex.load(std::memory_order_relaxed);
+        if (head == tailIndex.load(std::memory_order_acquire)) return false;
+
+        out = std::move(slots[head & (Capacity - 1)]);
+        slots[head & (Capacity - 1)] = T(); // Release the moved-from storage now, not on the next lap
+        headIndex.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Approximate from any thread (head is read first so the result never underflows)
+    size_t Size() const {
+        size_t head = headIndex.load(std::memory_order_acquire);
+        return tailIndex.load(std::memory_order_acquire) - head;
+    }
+
+    bool Empty() const { return Size() == 0; }
+
+    static constexpr size_t capacity = Capacity;
+
+private:
+    // Indices only grow; the slot is index & (Capacity - 1). Separate cache lines so the
+    // producer and consumer don't invalidate each other on every operation.
+    alignas(64) std::atomic<size_t> headIndex{0}; // Next slot to pop (written by consumer)
+    alignas(64) std::atomic<size_t> tailIndex{0}; // Next slot to push (written by producer)
+    alignas(64) T slots[Capacity];
+};
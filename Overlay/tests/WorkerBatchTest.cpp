@@ -0,0 +1,134 @@
+// BlockESP worker passes: batches that arrive together must apply as if they came one by one,
+// and the memory budget must hold. Built with -DXAI_BUILD_TESTS=ON, run by ctest.
+#include "../src/modules/BlockESP.h"
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <thread>
+
+// Friend of BlockESP: queues batches straight into the worker ring and reads the cache back
+struct BlockESPTest {
+    BlockESP esp{ nullptr };
+    int failures = 0;
+
+    BlockESPTest() { esp.blocks["diamond_ore"].enabled = true; }
+
+    static BlockUpdate Add(int x, int y, int z) {
+        BlockUpdate u;
+        u.remove = false;
+        u.id = "diamond_ore";
+        u.x = x; u.y = y; u.z = z;
+        return u;
+    }
+
+    static WorkerBatch Switch(const std::string& key) {
+        WorkerBatch batch;
+        batch.switchWorld = true;
+        batch.worldFile = (std::filesystem::path("cache") / "blockesp" / ("worker-batch-test-" + key + ".bin")).string();
+        return batch;
+    }
+
+    // Pushes every batch before waking the worker, so it sees them in one coalescing pass
+    void Queue(std::vector<WorkerBatch> batches) {
+        for (auto& batch : batches) esp.workerRing.TryPush(std::move(batch));
+        { std::lock_guard<std::mutex> lock(esp.queueMutex); }
+        esp.queueCV.notify_one();
+        for (int i = 0; i < 400 && (!esp.workerRing.Empty() || esp.hasDeferredBatch); i++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(50)); // Let the last pass finish
+    }
+
+    bool Has(int x, int y, int z) {
+        std::shared_lock<std::shared_mutex> lock(esp.chunkMapMutex);
+        auto it = esp.chunkMap.find({ x >> 4, y >> 4, z >> 4 });
+        return it != esp.chunkMap.end() && it->second.blocks.count((x & 15) | ((y & 15) << 4) | ((z & 15) << 8)) != 0;
+    }
+
+    void Expect(bool condition, const char* what) {
+        if (condition) return;
+        printf("FAILED: %s\n", what);
+        failures++;
+    }
+
+    // The old world's last updates and the switch away from it, back to back (Render's
+    // worldSplit hand-over): the updates must end up in the old world's file
+    void SplitDataThenSwitch() {
+        Queue([] { std::vector<WorkerBatch> b; b.push_back(Switch("a")); return b; }());
+
+        std::vector<WorkerBatch> batches;
+        WorkerBatch last;
+        last.updates.push_back(Add(5, 70, 5));
+        batches.push_back(std::move(last));
+        WorkerBatch next = Switch("b");
+        next.updates.push_back(Add(40, 70, 40));
+        batches.push_back(std::move(next));
+        Queue(std::move(batches));
+
+        Expect(!Has(5, 70, 5), "old world's block leaked into the new world");
+        Expect(Has(40, 70, 40), "new world's block missing after the switch");
+
+        Queue([] { std::vector<WorkerBatch> b; b.push_back(Switch("a")); return b; }());
+        Expect(Has(5, 70, 5), "old world's last update was not saved with it");
+        Expect(!Has(40, 70, 40), "new world's block saved into the old world");
+    }
+
+    // An update queued before its column's unload must not survive the unload
+    void UpdateThenUnload() {
+        std::vector<WorkerBatch> batches;
+        WorkerBatch update;
+        update.updates.push_back(Add(6, 70, 6));
+        update.updates.push_back(Add(70, 70, 6));
+        batches.push_back(std::move(update));
+        WorkerBatch unload;
+        unload.unloads.push_back({ 0, 0 });
+        batches.push_back(std::move(unload));
+        Queue(std::move(batches));
+
+        Expect(!Has(6, 70, 6), "unloaded column came back");
+        Expect(Has(70, 70, 6), "neighbouring column lost");
+    }
+
+    // A budget below what is in range: far columns go, then the range comes down
+    void OverBudget() {
+        esp.memoryBudget.store(1, std::memory_order_relaxed);
+        std::vector<WorkerBatch> batches;
+        WorkerBatch update;
+        update.updates.push_back(Add(5, 70, 5));
+        update.updates.push_back(Add(16 * 20 + 5, 70, 5)); // Past keepRange
+        batches.push_back(std::move(update));
+        Queue(std::move(batches));
+
+        Expect(Has(5, 70, 5), "column at the camera evicted");
+        Expect(!Has(16 * 20 + 5, 70, 5), "column past the keep range not evicted");
+        int limit = esp.budgetRange.load();
+        Expect(limit != 0 && limit < esp.renderRange, "range not lowered for a budget below the data in range");
+    }
+};
+
+int main() {
+    int failures = 0;
+    {
+        BlockESPTest test;
+        test.SplitDataThenSwitch();
+        failures += test.failures;
+    }
+    {
+        BlockESPTest test;
+        test.UpdateThenUnload();
+        failures += test.failures;
+    }
+
+    {
+        BlockESPTest test;
+        test.OverBudget();
+        failures += test.failures;
+    }
+
+    std::error_code ec;
+    for (const char* key : { "a", "b" }) {
+        std::filesystem::remove(std::filesystem::path("cache") / "blockesp" / (std::string("worker-batch-test-") + key + ".bin"), ec);
+    }
+    printf(failures ? "%d check(s) failed\n" : "All checks passed\n", failures);
+    return failures ? 1 : 0;
+}
@@ -2,6 +2,7 @@ package xai.client.backend;
 
 import com.mojang.blaze3d.platform.InputConstants;
 import net.minecraft.client.Minecraft;
+import net.minecraft.world.level.ChunkPos;
 
 import xai.client.module.BlockESP;
 
@@ -10,6 +11,8 @@ import java.io.DataInputStream;
 import java.io.IOException;
 import java.net.ServerSocket;
 import java.net.Socket;
+import java.util.ArrayList;
+import java.util.HashMap;
 import java.util.List;
 import java.util.Map;
 import java.util.Set;
@@ -24,6 +27,7 @@ public class SocketServer {
     private static final int PORT = 25566;
 
     private ExecutorService networkExecutor;
+    private ExecutorService sendExecutor; // One thread: data reaches the overlay in the order it was sent
 
     private final List<DataOutputStream> clients = new CopyOnWriteArrayList<>();
     private final Map<String, Boolean> moduleStates = new ConcurrentHashMap<>();
@@ -109,6 +113,11 @@ public class SocketServer {
             t.setDaemon(true);
             return t;
         });
+        sendExecutor = Executors.newSingleThreadExecutor(r -> {
+            Thread t = new Thread(r, "Xai-Send-Thread");
+            t.setDaemon(true);
+            return t;
+        });
         
         networkExecutor.submit(() -> {
             try {
@@ -121,15 +130,26 @@ public class SocketServer {
                         socket.setTcpNoDelay(true);
                         
                         DataOutputStream out = new DataOutputStream(socket.getOutputStream());
-                        clients.add(out);
                         
                         // Notify listeners (e.g. ESP to clear cache)
                         for (Runnable r : connectionListeners) {
                             r.run();
                         }
                         
-                        // Send current state
-                        BlockESP.getInstance().sendFullState(out);
+                        // Name the world; the overlay answers with its cached column hashes
+                        // and only the columns that differ are sent (BlockESP.handleManifest).
+                        // Queued with the sends so the new client gets nothing ahead of it.
+                        sendExecutor.submit(() -> {
+                            try {
+                                synchronized (out) {
+                                    BlockESP.getInstance().sendWorldIdentity(out);
+                                    out.flush();
+                                }
+                                clients.add(out);
+                            } catch (IOException e) {
+                                e.printStackTrace();
+                            }
+                        });
                         
                         networkExecutor.submit(() -> handleClientRead(socket));
                         
@@ -157,12 +177,12 @@ public class SocketServer {
             if (onComplete != null) onComplete.run();
             return;
         }
-        if (networkExecutor == null || networkExecutor.isShutdown()) {
+        if (sendExecutor == null || sendExecutor.isShutdown()) {
             if (onComplete != null) onComplete.run();
             return;
         }
         
-        networkExecutor.submit(() -> {
+        sendExecutor.submit(() -> {
             for (DataOutputStream out : clients) {
                 synchronized (out) {
                     try {
@@ -207,6 +227,21 @@ public class SocketServer {
                     
                     BlockESP.getInstance().updateWantedBlocks(newWanted);
                     
+                } else if (header == 0xB10CD1F) { // Block List Diff (removed, then added)
+                    List<String> removed = new ArrayList<>();
+                    List<String> added = new ArrayList<>();
+                    for (List<String> list : List.of(removed, added)) {
+                        int count = in.readInt();
+                        for (int i = 0; i < count; i++) {
+                            int len = in.readInt();
+                            byte[] idBytes = new byte[len];
+                            in.readFully(idBytes);
+                            list.add(new String(idBytes));
+                        }
+                    }
+
+                    BlockESP.getInstance().updateWantedDiff(added, removed);
+
                 } else if (header == 0xE581) { // ESP Settings Update
                     boolean generic = in.readByte() != 0;
                     boolean all = in.readByte() != 0;
@@ -226,6 +261,41 @@ public class SocketServer {
                     for (int i = 0; i < count; i++) {
                         watchedHotkeys.add(in.readInt());
                     }
+                } else if (header == 0x5B5C0) { // BlockESP Interest Subscription
+                    int range = in.readInt();
+                    int cx = in.readInt();
+                    int cy = in.readInt();
+                    int cz = in.readInt();
+                    boolean hasFrustum = in.readByte() != 0;
+                    float yaw = 0, halfFov = 0;
+                    if (hasFrustum) {
+                        yaw = in.readFloat();
+                        halfFov = in.readFloat();
+                    }
+                    int radius = (range + 15) / 16 + 1;
+                    BlockESP.getInstance().updateSubscription(new BlockESP.Subscription(cx, cy, cz, radius, hasFrustum, yaw, halfFov));
+                } else if (header == 0xE71C7 || header == 0xE71C8) { // BlockESP Columns Evicted / Back In Range
+                    int count = in.readInt();
+                    List<ChunkPos> columns = new ArrayList<>(count);
+                    for (int i = 0; i < count; i++) {
+                        int cx = in.readInt();
+                        int cz = in.readInt();
+                        columns.add(new ChunkPos(cx, cz));
+                    }
+                    if (header == 0xE71C7) {
+                        BlockESP.getInstance().forgetColumns(columns);
+                    } else {
+                        BlockESP.getInstance().restoreColumns(columns);
+                    }
+                } else if (header == 0xC01A5C) { // Cache Manifest (column hashes)
+                    int count = in.readInt();
+                    Map<ChunkPos, Long> manifest = new HashMap<>(count * 2);
+                    for (int i = 0; i < count; i++) {
+                        int cx = in.readInt();
+                        int cz = in.readInt();
+                        manifest.put(new ChunkPos(cx, cz), in.readLong());
+                    }
+                    BlockESP.getInstance().handleManifest(manifest);
                 } else if (header == 0xBADF00D) { // Disable Request
                     shutdown(true);
                 }
@@ -253,6 +323,7 @@ public class SocketServer {
         
         BlockESP.getInstance().stop();
         if (networkExecutor != null) networkExecutor.shutdownNow();
+        if (sendExecutor != null) sendExecutor.shutdownNow();
         
         try {
             if (serverSocket != null) {
@@ -1,6 +1,5 @@
 package xai.client.mixin;
 
-import net.minecraft.client.Minecraft;
 import net.minecraft.network.protocol.game.ClientboundBlockUpdatePacket;
 import net.minecraft.network.protocol.game.ClientboundLoginPacket;
 import net.minecraft.network.protocol.game.ClientboundRespawnPacket;
@@ -37,13 +36,14 @@ public class MixinClientPacketListener {
         });
     }
 
+    // Directly rather than deferred: chunk packets queued behind this one must see the new world
     @Inject(method = "handleLogin", at = @At("RETURN"))
     private void onLogin(ClientboundLoginPacket packet, CallbackInfo ci) {
-        Minecraft.getInstance().execute(() -> BlockESP.getInstance().rescanAllLoaded(true));
+        BlockESP.getInstance().onLevelChanged();
     }
 
     @Inject(method = "handleRespawn", at = @At("RETURN"))
     private void onRespawn(ClientboundRespawnPacket packet, CallbackInfo ci) {
-        Minecraft.getInstance().execute(() -> BlockESP.getInstance().rescanAllLoaded(true));
+        BlockESP.getInstance().onLevelChanged();
     }
 }
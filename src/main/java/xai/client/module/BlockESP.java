@@ -2,9 +2,12 @@ package xai.client.module;
 
 import xai.client.backend.SocketServer;
 import net.minecraft.core.BlockPos;
+import net.minecraft.core.SectionPos;
 import net.minecraft.core.registries.BuiltInRegistries;
+import net.minecraft.world.level.block.Block;
 import net.minecraft.world.level.block.state.BlockState;
 import net.minecraft.world.level.chunk.LevelChunk;
+import net.minecraft.world.level.chunk.LevelChunkSection;
 import net.minecraft.world.level.ChunkPos;
 import net.minecraft.client.Minecraft;
 import net.minecraft.world.level.Level;
@@ -18,15 +21,24 @@ import java.util.*;
 import java.util.concurrent.ConcurrentHashMap;
 import java.util.concurrent.ExecutorService;
 import java.util.concurrent.Executors;
+import java.util.function.BiConsumer;
 
 public class BlockESP {
     private static final BlockESP INSTANCE = new BlockESP();
     
     // State
     private final Set<String> wantedBlocks = ConcurrentHashMap.newKeySet();
+    private volatile Map<BlockState, String> wantedStates = new IdentityHashMap<>(); // Replaced, never modified
     private final Map<BlockPos, String> knownBlocks = new ConcurrentHashMap<>();
     private final Map<ChunkPos, List<BlockPos>> chunkCache = new ConcurrentHashMap<>();
     private final Set<ChunkPos> sentChunks = ConcurrentHashMap.newKeySet();
+    private final Set<ChunkPos> evictedChunks = ConcurrentHashMap.newKeySet(); // Dropped by the overlay's memory budget, not scanned until it asks
+    private volatile String worldKey; // Server/world|dimension, the overlay keeps one block cache per key
+    private volatile int worldEpoch;  // Bumped with worldKey; block data of an older epoch is never written
+    private int taskEpoch;            // Scan thread: epoch the running task started in
+    private boolean resyncPending;    // Scan thread: new world announced, scans stay silent until its manifest
+    private final Map<ChunkPos, Long> overlayHashes = new ConcurrentHashMap<>(); // Manifest hashes of columns not loaded here yet
+    private volatile Subscription subscription; // Columns the overlay draws, null until it says
     
     // Executor for scanning (keep separate from Network)
     private ExecutorService scanExecutor;
@@ -39,6 +51,38 @@ public class BlockESP {
         }
     }
     
+    // Interest area from the overlay (0x5B5C0): a circle of columns around the camera column,
+    // optionally with the horizontal view cone used to scan what is in view first
+    public static class Subscription {
+        public final int cx, cy, cz, radius;
+        public final boolean hasFrustum;
+        public final double dirX, dirZ, cosHalfFov;
+        public Subscription(int cx, int cy, int cz, int radius, boolean hasFrustum, float yaw, float halfFov) {
+            this.cx = cx; this.cy = cy; this.cz = cz; this.radius = radius;
+            this.hasFrustum = hasFrustum;
+            double yawRad = Math.toRadians(yaw);
+            this.dirX = -Math.sin(yawRad);
+            this.dirZ = Math.cos(yawRad);
+            // Widened by a column's worth so columns at the screen edge still count as in view
+            this.cosHalfFov = Math.cos(Math.toRadians(Math.min(halfFov + 15.0, 180.0)));
+        }
+
+        public boolean contains(ChunkPos c, int margin) {
+            int dx = c.x - cx, dz = c.z - cz;
+            int r = radius + margin;
+            return dx * dx + dz * dz <= r * r;
+        }
+
+        // Squared column distance; columns outside the view cone count as twice as far
+        public double priority(ChunkPos c) {
+            int dx = c.x - cx, dz = c.z - cz;
+            double d2 = dx * dx + dz * dz;
+            if (!hasFrustum || d2 <= 2) return d2;
+            double dot = (dx * dirX + dz * dirZ) / Math.sqrt(d2);
+            return dot >= cosHalfFov ? d2 : d2 * 4;
+        }
+    }
+    
     public static BlockESP getInstance() {
         return INSTANCE;
     }
@@ -48,16 +92,21 @@ public class BlockESP {
             scanExecutor = Executors.newSingleThreadExecutor(r -> new Thread(r, "Xai-Scan-Thread"));
         }
 
-        // Register Events
+        // A new overlay has no evictions of its own
+        SocketServer.getInstance().addConnectionListener(evictedChunks::clear);
+
+        // Register Events. Handled on the scan thread so they stay ordered with a world change;
+        // the level check skips the previous level's chunks going away after a respawn.
         ClientChunkEvents.CHUNK_LOAD.register((world, chunk) -> {
-            if (world instanceof net.minecraft.client.multiplayer.ClientLevel) {
-                scanChunk(chunk);
+            if (world == Minecraft.getInstance().level) {
+                submitScan(() -> scanChunk(chunk));
             }
         });
         
         ClientChunkEvents.CHUNK_UNLOAD.register((world, chunk) -> {
-            if (world instanceof net.minecraft.client.multiplayer.ClientLevel) {
-                unloadChunk(chunk.getPos());
+            if (world == Minecraft.getInstance().level) {
+                ChunkPos cPos = chunk.getPos();
+                submitScan(() -> unloadChunk(cPos));
             }
         });
         
@@ -73,9 +122,19 @@ public class BlockESP {
         if (scanExecutor != null) {
             scanExecutor.shutdownNow();
         }
-        knownBlocks.clear();
-        chunkCache.clear();
-        sentChunks.clear();
+        clear();
+    }
+
+    // Runs a task on the scan thread, unless the world changes before it starts: the block data
+    // it sends is tagged with that world and dropped if a change overtakes it (sendBlockData)
+    private void submitScan(Runnable task) {
+        if (scanExecutor == null || scanExecutor.isShutdown()) return;
+        int epoch = worldEpoch;
+        scanExecutor.submit(() -> {
+            if (epoch != worldEpoch) return;
+            taskEpoch = epoch;
+            task.run();
+        });
     }
     
     public void updateWantedBlocks(Set<String> newWanted) {
@@ -92,6 +151,7 @@ public class BlockESP {
         
         wantedBlocks.addAll(newWanted);
         wantedBlocks.retainAll(newWanted);
+        wantedStates = statesOf(newWanted);
         
         System.out.println("[BlockESP] Update. Added: " + added + ", Removed: " + removed);
         
@@ -99,22 +159,38 @@ public class BlockESP {
             for (String id : removed) {
                 sendDeleteBlockType(id);
             }
-            scanExecutor.submit(() -> {
-                knownBlocks.entrySet().removeIf(entry -> removed.contains(entry.getValue()));
-                // Rebuild chunk cache
-                chunkCache.clear();
-                for (BlockPos pos : knownBlocks.keySet()) {
-                    ChunkPos cPos = new ChunkPos(pos);
-                    chunkCache.computeIfAbsent(cPos, k -> new ArrayList<>()).add(pos);
-                }
-            });
+            dropTypes(removed);
         }
         
         if (!added.isEmpty()) {
              // Only scan for the NEW blocks
-             scanExecutor.submit(() -> scanNewBlocks(added));
+             submitScan(() -> scanNewBlocks(added));
         }
     }
+
+    // Incremental block list change (0xB10CD1F). The overlay already dropped the removed types
+    // itself, so unlike a full list nothing is echoed back. Removes apply first: a type in both
+    // was switched off and on again and is scanned for anew.
+    public void updateWantedDiff(List<String> added, List<String> removed) {
+        System.out.println("[BlockESP] Diff. Added: " + added + ", Removed: " + removed);
+
+        wantedBlocks.removeAll(removed);
+        wantedBlocks.addAll(added);
+        wantedStates = statesOf(wantedBlocks);
+
+        if (!removed.isEmpty()) dropTypes(removed);
+        if (!added.isEmpty()) submitScan(() -> scanNewBlocks(added));
+    }
+
+    // Forgets the known blocks of the given types (scan thread, ordered with the scans)
+    private void dropTypes(List<String> removed) {
+        submitScan(() -> {
+            for (List<BlockPos> list : chunkCache.values()) {
+                list.removeIf(pos -> removed.contains(knownBlocks.get(pos)));
+            }
+            knownBlocks.values().removeIf(removed::contains);
+        });
+    }
     
     // Scan specific blocks in all currently loaded chunks
     private void scanNewBlocks(List<String> newBlockIds) {
@@ -125,73 +201,82 @@ public class BlockESP {
         
         List<LevelChunk> chunksToScan = new ArrayList<>();
         mc.executeBlocking(() -> {
-            if (mc.level != null) {
-                int r = mc.options.renderDistance().get();
-                BlockPos p = mc.player.blockPosition();
-                int cx = p.getX() >> 4;
-                int cz = p.getZ() >> 4;
-                
-                for (int x = -r - 2; x <= r + 2; x++) {
-                    for (int z = -r - 2; z <= r + 2; z++) {
-                         if (mc.level.getChunkSource().hasChunk(cx + x, cz + z)) {
-                             chunksToScan.add(mc.level.getChunk(cx + x, cz + z));
-                         }
-                    }
-                }
-                
-                // Sort chunks by distance from player (Center Outwards)
-                chunksToScan.sort(Comparator.comparingDouble(c -> {
-                    if (c == null) return Double.MAX_VALUE;
-                    int dx = c.getPos().x - cx;
-                    int dz = c.getPos().z - cz;
-                    return dx * dx + dz * dz;
-                }));
+            if (mc.level != null && mc.player != null) {
+                chunksToScan.addAll(interestChunks(mc, false));
             }
         });
         
+        Map<BlockState, String> states = statesOf(newBlockIds);
         for (LevelChunk chunk : chunksToScan) {
-            if (chunk == null) continue;
+            // Columns not scanned yet get every wanted type when their turn comes
+            if (chunk == null || !sentChunks.contains(chunk.getPos())) continue;
             try {
-                scanChunkForSpecificBlocks(chunk, newBlockIds);
+                scanChunkForSpecificBlocks(chunk, states);
             } catch (Exception e) {
                 System.err.println("[BlockESP] Error scanning chunk " + chunk.getPos() + ": " + e.getMessage());
             }
         }
     }
     
-    private void scanChunkForSpecificBlocks(LevelChunk chunk, List<String> blockIds) {
+    private void scanChunkForSpecificBlocks(LevelChunk chunk, Map<BlockState, String> states) {
         ChunkPos cPos = chunk.getPos();
         List<FoundBlock> added = new ArrayList<>();
         
-        int minY = -64;
-        int maxY = 320;
+        forEachWanted(chunk, states, (targetPos, id) -> {
+            if (!knownBlocks.containsKey(targetPos)) {
+                knownBlocks.put(targetPos, id);
+                chunkCache.computeIfAbsent(cPos, k -> new ArrayList<>()).add(targetPos);
+                added.add(new FoundBlock(id, targetPos.getX(), targetPos.getY(), targetPos.getZ()));
+            }
+        });
         
-        for (int by = minY; by < maxY; by++) {
-            for (int bx = 0; bx < 16; bx++) {
-                for (int bz = 0; bz < 16; bz++) {
-                    BlockPos targetPos = new BlockPos(cPos.getMinBlockX() + bx, by, cPos.getMinBlockZ() + bz);
-                    BlockState state = chunk.getBlockState(targetPos);
-                    if (!state.isAir()) {
-                        String id = BuiltInRegistries.BLOCK.getKey(state.getBlock()).getPath();
-                        if (blockIds.contains(id)) {
-                             if (!knownBlocks.containsKey(targetPos)) {
-                                knownBlocks.put(targetPos, id);
-                                chunkCache.computeIfAbsent(cPos, k -> new ArrayList<>()).add(targetPos);
-                                added.add(new FoundBlock(id, targetPos.getX(), targetPos.getY(), targetPos.getZ()));
-                            }
+        if (!added.isEmpty()) {
+            sendSections(added);
+        }
+    }
+
+    // Every state of the given blocks, mapped to the id the overlay knows them by
+    private static Map<BlockState, String> statesOf(Collection<String> blockIds) {
+        Map<BlockState, String> states = new IdentityHashMap<>();
+        if (blockIds.isEmpty()) return states;
+        for (Block block : BuiltInRegistries.BLOCK) {
+            String id = BuiltInRegistries.BLOCK.getKey(block).getPath();
+            if (!blockIds.contains(id)) continue;
+            for (BlockState state : block.getStateDefinition().getPossibleStates()) {
+                states.put(state, id);
+            }
+        }
+        return states;
+    }
+
+    // Visits the wanted blocks of a chunk in section index order. A section whose palette holds
+    // none of the states is skipped without reading a block; the rest compare states by identity.
+    private static void forEachWanted(LevelChunk chunk, Map<BlockState, String> states, BiConsumer<BlockPos, String> action) {
+        if (states.isEmpty()) return;
+        ChunkPos cPos = chunk.getPos();
+        LevelChunkSection[] sections = chunk.getSections();
+        for (int i = 0; i < sections.length; i++) {
+            LevelChunkSection section = sections[i];
+            if (section.hasOnlyAir() || !section.maybeHas(states::containsKey)) continue;
+
+            int baseY = SectionPos.sectionToBlockCoord(chunk.getSectionYFromSectionIndex(i));
+            for (int z = 0; z < 16; z++) {
+                for (int y = 0; y < 16; y++) {
+                    for (int x = 0; x < 16; x++) {
+                        String id = states.get(section.getBlockState(x, y, z));
+                        if (id != null) {
+                            action.accept(new BlockPos(cPos.getMinBlockX() + x, baseY + y, cPos.getMinBlockZ() + z), id);
                         }
                     }
                 }
             }
         }
-        
-        if (!added.isEmpty()) {
-            sendBlockDiff(added, new ArrayList<>());
-        }
     }
 
     public void scanChunk(LevelChunk chunk) {
         ChunkPos cPos = chunk.getPos();
+        // Outside the overlay's interest: picked up when a subscription covers it
+        if (!isSubscribed(cPos)) return;
         // Mark as sent/scanned
         sentChunks.add(cPos);
         
@@ -200,37 +285,36 @@ public class BlockESP {
         List<BlockPos> foundInChunk = new ArrayList<>();
         List<FoundBlock> added = new ArrayList<>();
         
-        int minY = -64;
-        int maxY = 320;
-        
-        for (int by = minY; by < maxY; by++) {
-            for (int bx = 0; bx < 16; bx++) {
-                for (int bz = 0; bz < 16; bz++) {
-                    BlockPos targetPos = new BlockPos(cPos.getMinBlockX() + bx, by, cPos.getMinBlockZ() + bz);
-                    BlockState state = chunk.getBlockState(targetPos);
-                    if (!state.isAir()) {
-                        String id = BuiltInRegistries.BLOCK.getKey(state.getBlock()).getPath();
-                        if (wantedBlocks.contains(id)) {
-                            foundInChunk.add(targetPos);
-                            if (!knownBlocks.containsKey(targetPos)) {
-                                knownBlocks.put(targetPos, id);
-                                added.add(new FoundBlock(id, targetPos.getX(), targetPos.getY(), targetPos.getZ()));
-                            }
-                        }
-                    }
-                }
+        forEachWanted(chunk, wantedStates, (targetPos, id) -> {
+            foundInChunk.add(targetPos);
+            if (!knownBlocks.containsKey(targetPos)) {
+                knownBlocks.put(targetPos, id);
+                added.add(new FoundBlock(id, targetPos.getX(), targetPos.getY(), targetPos.getZ()));
             }
-        }
+        });
         
         chunkCache.put(cPos, foundInChunk);
         
+        // Right after a world change the overlay's manifest says what it still needs
+        if (resyncPending) return;
+        Long cached = overlayHashes.remove(cPos);
+        if (cached != null) {
+            // Cached there from an earlier visit: replace it only if it changed since
+            List<BlockPos> blocks = sortedColumn(cPos);
+            if (cached != columnHash(blocks)) {
+                sendColumns(List.of(), Map.of(cPos, foundBlocks(blocks)));
+            }
+            return;
+        }
+        
         if (!added.isEmpty()) {
-            sendBlockDiff(added, new ArrayList<>());
+            sendSections(added);
         }
     }
     
     public void unloadChunk(ChunkPos cPos) {
         sentChunks.remove(cPos);
+        overlayHashes.remove(cPos);
         List<BlockPos> blocks = chunkCache.remove(cPos);
         if (blocks != null) {
             for (BlockPos p : blocks) {
@@ -243,11 +327,13 @@ public class BlockESP {
     
     public void handleBlockUpdate(BlockPos pos, BlockState newState) {
         if (scanExecutor != null && !scanExecutor.isShutdown()) {
-            scanExecutor.submit(() -> {
+            submitScan(() -> {
                 if (wantedBlocks.isEmpty()) return;
+                // Unscanned (or unsubscribed) columns read the current state when scanned
+                if (!sentChunks.contains(new ChunkPos(pos))) return;
                 
-                String id = BuiltInRegistries.BLOCK.getKey(newState.getBlock()).getPath();
-                boolean isWanted = wantedBlocks.contains(id);
+                String id = wantedStates.get(newState);
+                boolean isWanted = id != null;
                 boolean wasKnown = knownBlocks.containsKey(pos);
                 
                 List<FoundBlock> added = new ArrayList<>();
@@ -273,114 +359,214 @@ public class BlockESP {
         }
     }
     
-    public void rescanAllLoaded(boolean clear) {
-        if (clear) clear();
+    public void ensureChunksSent() {
+        if (scanExecutor == null || scanExecutor.isShutdown()) return;
+        
         Minecraft mc = Minecraft.getInstance();
         if (mc.level == null) return;
         
         mc.execute(() -> {
-            if (mc.level == null) return;
-            int r = mc.options.renderDistance().get();
-            BlockPos p = mc.player.blockPosition();
-            int cx = p.getX() >> 4;
-            int cz = p.getZ() >> 4;
-            
-            List<LevelChunk> chunksToScan = new ArrayList<>();
-            for (int x = -r - 2; x <= r + 2; x++) {
-                for (int z = -r - 2; z <= r + 2; z++) {
-                     if (mc.level.getChunkSource().hasChunk(cx + x, cz + z)) {
-                         chunksToScan.add(mc.level.getChunk(cx + x, cz + z));
+             if (mc.level == null || mc.player == null) return;
+             List<LevelChunk> missingChunks = interestChunks(mc, true);
+             
+             if (!missingChunks.isEmpty()) {
+                 submitScan(() -> {
+                     for (LevelChunk c : missingChunks) {
+                         if (!sentChunks.contains(c.getPos())) scanChunk(c);
                      }
+                 });
+             }
+        });
+    }
+
+    // Columns the overlay wants; with no subscription yet, everything loaded is
+    public boolean isSubscribed(ChunkPos cPos) {
+        if (evictedChunks.contains(cPos)) return false;
+        Subscription s = subscription;
+        return s == null || s.contains(cPos, 2); // Slack so the edge does not flicker
+    }
+
+    // Overlay's interest area, or the render distance around the player before it sent one
+    private Subscription interest(Minecraft mc) {
+        Subscription s = subscription;
+        if (s != null) return s;
+        BlockPos p = mc.player.blockPosition();
+        return new Subscription(p.getX() >> 4, p.getY() >> 4, p.getZ() >> 4,
+                mc.options.renderDistance().get() + 2, false, 0, 0);
+    }
+
+    // Loaded chunks in the interest area, nearest (and in view) first. Client thread only.
+    private List<LevelChunk> interestChunks(Minecraft mc, boolean unsentOnly) {
+        Subscription s = interest(mc);
+        List<LevelChunk> chunks = new ArrayList<>();
+        for (int x = -s.radius; x <= s.radius; x++) {
+            for (int z = -s.radius; z <= s.radius; z++) {
+                ChunkPos cp = new ChunkPos(s.cx + x, s.cz + z);
+                if (!s.contains(cp, 0) || evictedChunks.contains(cp)) continue;
+                if (unsentOnly && sentChunks.contains(cp)) continue;
+                if (mc.level.getChunkSource().hasChunk(cp.x, cp.z)) {
+                    chunks.add(mc.level.getChunk(cp.x, cp.z));
                 }
             }
-            
-            // Sort chunks by distance from player (Center Outwards)
-            chunksToScan.sort(Comparator.comparingDouble(c -> {
-                int dx = c.getPos().x - cx;
-                int dz = c.getPos().z - cz;
-                return dx * dx + dz * dz;
-            }));
-
-            if (scanExecutor != null) {
-                for (LevelChunk chunk : chunksToScan) {
-                    scanExecutor.submit(() -> scanChunk(chunk));
+        }
+        chunks.sort(Comparator.comparingDouble(c -> s.priority(c.getPos())));
+        return chunks;
+    }
+
+    // The overlay evicted these columns to stay within its memory budget (0xE71C7): forget them
+    // without sending anything, and leave them alone until it asks for them back
+    public void forgetColumns(List<ChunkPos> columns) {
+        submitScan(() -> {
+            for (ChunkPos cPos : columns) {
+                evictedChunks.add(cPos);
+                sentChunks.remove(cPos);
+                overlayHashes.remove(cPos);
+                List<BlockPos> blocks = chunkCache.remove(cPos);
+                if (blocks != null) {
+                    for (BlockPos p : blocks) {
+                        knownBlocks.remove(p);
+                    }
                 }
             }
         });
     }
 
-    public void ensureChunksSent() {
+    // Evicted columns the camera is in range of again (0xE71C8): scan the loaded ones now,
+    // the others when they load
+    public void restoreColumns(List<ChunkPos> columns) {
+        submitScan(() -> {
+            columns.forEach(evictedChunks::remove);
+
+            Minecraft mc = Minecraft.getInstance();
+            List<LevelChunk> loaded = new ArrayList<>();
+            mc.executeBlocking(() -> {
+                if (mc.level == null) return;
+                for (ChunkPos cPos : columns) {
+                    if (mc.level.getChunkSource().hasChunk(cPos.x, cPos.z)) {
+                        loaded.add(mc.level.getChunk(cPos.x, cPos.z));
+                    }
+                }
+            });
+            for (LevelChunk c : loaded) {
+                if (!sentChunks.contains(c.getPos())) scanChunk(c);
+            }
+        });
+    }
+
+    // New interest from the overlay: drop the columns that left it, scan the ones that entered
+    public void updateSubscription(Subscription s) {
+        subscription = s;
         if (scanExecutor == null || scanExecutor.isShutdown()) return;
-        
+
         Minecraft mc = Minecraft.getInstance();
-        if (mc.level == null) return;
-        
         mc.execute(() -> {
-             if (mc.level == null) return;
-             int r = mc.options.renderDistance().get();
-             BlockPos p = mc.player.blockPosition();
-             int cx = p.getX() >> 4;
-             int cz = p.getZ() >> 4;
-             
-             List<LevelChunk> missingChunks = new ArrayList<>();
-             
-             for (int x = -r; x <= r; x++) {
-                for (int z = -r; z <= r; z++) {
-                     int targetX = cx + x;
-                     int targetZ = cz + z;
-                     ChunkPos cp = new ChunkPos(targetX, targetZ);
-                     
-                     if (mc.level.getChunkSource().hasChunk(targetX, targetZ)) {
-                         if (!sentChunks.contains(cp)) {
-                             missingChunks.add(mc.level.getChunk(targetX, targetZ));
-                         }
-                     }
+            if (mc.level == null || mc.player == null) return;
+            List<LevelChunk> missingChunks = interestChunks(mc, true);
+            submitScan(() -> {
+                for (ChunkPos cPos : new ArrayList<>(sentChunks)) {
+                    if (!s.contains(cPos, 2)) unloadChunk(cPos);
                 }
-             }
-             
-             if (!missingChunks.isEmpty()) {
-                 // Sort chunks by distance from player (Center Outwards)
-                 missingChunks.sort(Comparator.comparingDouble(c -> {
-                     int dx = c.getPos().x - cx;
-                     int dz = c.getPos().z - cz;
-                     return dx * dx + dz * dz;
-                 }));
-
-                 scanExecutor.submit(() -> {
-                     for (LevelChunk c : missingChunks) {
-                         scanChunk(c);
-                     }
-                 });
-             }
+                // Cached on the overlay but never loaded here within the new area
+                for (ChunkPos cPos : new ArrayList<>(overlayHashes.keySet())) {
+                    if (!s.contains(cPos, 2)) unloadChunk(cPos);
+                }
+                for (LevelChunk c : missingChunks) {
+                    if (subscription == s && !sentChunks.contains(c.getPos())) scanChunk(c);
+                }
+            });
         });
     }
 
-    private void sendBlockDiff(List<FoundBlock> added, List<BlockPos> removed) {
+    private interface BlockDataWriter {
+        void write(DataOutputStream out) throws IOException;
+    }
+
+    // Block data of the world the running scan task started in. Skipped if the world changed
+    // before it is written: the overlay switched caches on the identity ahead of it.
+    private void sendBlockData(BlockDataWriter writer) {
+        int epoch = taskEpoch;
         SocketServer.getInstance().sendData(out -> {
+            if (epoch != worldEpoch) return;
             try {
-                out.writeInt(0x0BE0C4D0); // Header
-                out.writeInt(added.size() + removed.size());
-                
-                for (BlockPos pos : removed) {
-                    out.writeByte(1); // REMOVE
-                    out.writeInt(pos.getX());
-                    out.writeInt(pos.getY());
-                    out.writeInt(pos.getZ());
+                writer.write(out);
+            } catch (IOException e) {
+                e.printStackTrace();
+            }
+        });
+    }
+
+    private void sendBlockDiff(List<FoundBlock> added, List<BlockPos> removed) {
+        sendBlockData(out -> writeBlockDiff(out, added, removed));
+    }
+
+    private void sendSections(List<FoundBlock> added) {
+        sendBlockData(out -> writeSections(out, added));
+    }
+
+    // Bulk adds (0x5EC7B10), a packet per 16^3 section: the ids once, then a u16 per block,
+    // (palette slot << 12) | local index, sorted by index. About 2 bytes per block instead of
+    // ~30 for a diff record; a section with more than 16 types takes several packets.
+    private static void writeSections(DataOutputStream out, List<FoundBlock> blocks) throws IOException {
+        Map<Long, List<FoundBlock>> bySection = new HashMap<>();
+        for (FoundBlock fb : blocks) {
+            bySection.computeIfAbsent(SectionPos.asLong(fb.x >> 4, fb.y >> 4, fb.z >> 4), k -> new ArrayList<>()).add(fb);
+        }
+
+        for (Map.Entry<Long, List<FoundBlock>> entry : bySection.entrySet()) {
+            List<FoundBlock> section = entry.getValue();
+            section.sort(Comparator.comparingInt(fb -> sectionIndex(fb.x, fb.y, fb.z)));
+
+            List<String> ids = new ArrayList<>();
+            for (FoundBlock fb : section) {
+                if (!ids.contains(fb.id)) ids.add(fb.id);
+            }
+
+            for (int first = 0; first < ids.size(); first += 16) {
+                List<String> palette = ids.subList(first, Math.min(first + 16, ids.size()));
+                int count = 0;
+                for (FoundBlock fb : section) {
+                    if (palette.contains(fb.id)) count++;
                 }
-                
-                for (FoundBlock fb : added) {
-                    out.writeByte(0); // ADD
-                    out.writeInt(fb.x);
-                    out.writeInt(fb.y);
-                    out.writeInt(fb.z);
-                    byte[] idBytes = fb.id.getBytes(StandardCharsets.UTF_8);
+
+                out.writeInt(0x5EC7B10); // SECTION BLOCKS Header
+                out.writeInt(SectionPos.x(entry.getKey()));
+                out.writeInt(SectionPos.y(entry.getKey()));
+                out.writeInt(SectionPos.z(entry.getKey()));
+                out.writeInt(palette.size());
+                for (String id : palette) {
+                    byte[] idBytes = id.getBytes(StandardCharsets.UTF_8);
                     out.writeInt(idBytes.length);
                     out.write(idBytes);
                 }
-            } catch (IOException e) {
-                e.printStackTrace();
+                out.writeInt(count);
+                for (FoundBlock fb : section) {
+                    int slot = palette.indexOf(fb.id);
+                    if (slot >= 0) out.writeShort((slot << 12) | sectionIndex(fb.x, fb.y, fb.z));
+                }
             }
-        });
+        }
+    }
+
+    private static void writeBlockDiff(DataOutputStream out, List<FoundBlock> added, List<BlockPos> removed) throws IOException {
+        out.writeInt(0x0BE0C4D0); // Header
+        out.writeInt(added.size() + removed.size());
+        
+        for (BlockPos pos : removed) {
+            out.writeByte(1); // REMOVE
+            out.writeInt(pos.getX());
+            out.writeInt(pos.getY());
+            out.writeInt(pos.getZ());
+        }
+        
+        for (FoundBlock fb : added) {
+            out.writeByte(0); // ADD
+            out.writeInt(fb.x);
+            out.writeInt(fb.y);
+            out.writeInt(fb.z);
+            byte[] idBytes = fb.id.getBytes(StandardCharsets.UTF_8);
+            out.writeInt(idBytes.length);
+            out.write(idBytes);
+        }
     }
 
     private void sendDeleteBlockType(String blockId) {
@@ -396,41 +582,170 @@ public class BlockESP {
         });
     }
     
-    private void sendChunkUnload(int cx, int cz) {
-        SocketServer.getInstance().sendData(out -> {
-            try {
-                out.writeInt(0xC400000); // CHUNK UNLOAD Header
-                out.writeInt(cx);
-                out.writeInt(cz);
-            } catch (IOException e) {
-                e.printStackTrace();
-            }
+    // Called on the client thread at the end of login/respawn, before any chunk of the new level
+    // is seen. Block data still queued for the old world is dropped (sendBlockData), the identity
+    // is queued behind what was already written, and the new world is scanned without sending
+    // until the overlay's manifest for its cache arrives.
+    public void onLevelChanged() {
+        Minecraft mc = Minecraft.getInstance();
+        if (mc.level == null) return;
+
+        String world;
+        if (mc.getSingleplayerServer() != null) {
+            world = "local/" + mc.getSingleplayerServer().getWorldData().getLevelName();
+        } else if (mc.getCurrentServer() != null) {
+            world = mc.getCurrentServer().ip;
+        } else {
+            world = "unknown";
+        }
+        String key = world + "|" + mc.level.dimension().location();
+        if (key.equals(worldKey)) return;
+
+        worldEpoch++;
+        worldKey = key;
+        SocketServer.getInstance().sendData(out -> writeWorldIdentity(out, key));
+        submitScan(() -> {
+            clear();
+            resyncPending = true;
         });
     }
 
-    public void sendFullState(DataOutputStream out) {
-        if (knownBlocks.isEmpty()) return;
+    public void sendWorldIdentity(DataOutputStream out) {
+        writeWorldIdentity(out, worldKey);
+    }
+
+    private static void writeWorldIdentity(DataOutputStream out, String key) {
+        if (key == null) return;
         try {
-            out.writeInt(0x0BE0C4D0);
-            out.writeInt(knownBlocks.size());
-            for (Map.Entry<BlockPos, String> entry : knownBlocks.entrySet()) {
-                out.writeByte(0);
-                BlockPos pos = entry.getKey();
-                out.writeInt(pos.getX());
-                out.writeInt(pos.getY());
-                out.writeInt(pos.getZ());
-                byte[] idBytes = entry.getValue().getBytes(StandardCharsets.UTF_8);
-                out.writeInt(idBytes.length);
-                out.write(idBytes);
-            }
+            out.writeInt(0x3071D0); // WORLD IDENTITY Header
+            byte[] keyBytes = key.getBytes(StandardCharsets.UTF_8);
+            out.writeInt(keyBytes.length);
+            out.write(keyBytes);
         } catch (IOException e) {
             e.printStackTrace();
         }
     }
+
+    private void sendChunkUnload(int cx, int cz) {
+        sendBlockData(out -> writeChunkUnload(out, cx, cz));
+    }
+
+    private static void writeChunkUnload(DataOutputStream out, int cx, int cz) throws IOException {
+        out.writeInt(0xC400000); // CHUNK UNLOAD Header
+        out.writeInt(cx);
+        out.writeInt(cz);
+    }
+
+    // Column hash shared with the overlay (BlockESP::BuildManifest): FNV-1a 64 over the column's
+    // blocks ordered by (section y, index in section), each fed as i32 section y and u16 index
+    // (both little-endian), the block id's bytes, then a 0 byte. An empty column hashes to the basis.
+    private static final long FNV_BASIS = 0xcbf29ce484222325L;
+    private static final long FNV_PRIME = 0x100000001b3L;
+
+    private static int sectionIndex(int x, int y, int z) {
+        return (x & 15) | ((y & 15) << 4) | ((z & 15) << 8);
+    }
+
+    private static int sectionIndex(BlockPos pos) {
+        return sectionIndex(pos.getX(), pos.getY(), pos.getZ());
+    }
+
+    private static int columnOrder(BlockPos pos) {
+        return ((pos.getY() >> 4) << 12) | sectionIndex(pos);
+    }
+
+    private long columnHash(List<BlockPos> blocks) {
+        long hash = FNV_BASIS;
+        for (BlockPos pos : blocks) {
+            String id = knownBlocks.get(pos);
+            if (id == null) continue;
+            int cy = pos.getY() >> 4;
+            int index = sectionIndex(pos);
+            for (int i = 0; i < 4; i++) hash = (hash ^ ((cy >> (i * 8)) & 0xFF)) * FNV_PRIME;
+            hash = (hash ^ (index & 0xFF)) * FNV_PRIME;
+            hash = (hash ^ (index >> 8)) * FNV_PRIME;
+            for (byte b : id.getBytes(StandardCharsets.UTF_8)) hash = (hash ^ (b & 0xFF)) * FNV_PRIME;
+            hash *= FNV_PRIME; // ^ 0
+        }
+        return hash;
+    }
+
+    // The column's known blocks in hash order, without duplicates
+    private List<BlockPos> sortedColumn(ChunkPos cPos) {
+        List<BlockPos> blocks = new ArrayList<>(new HashSet<>(chunkCache.getOrDefault(cPos, List.of())));
+        blocks.sort(Comparator.comparingInt(BlockESP::columnOrder));
+        return blocks;
+    }
+
+    private List<FoundBlock> foundBlocks(List<BlockPos> blocks) {
+        List<FoundBlock> found = new ArrayList<>();
+        for (BlockPos pos : blocks) {
+            String id = knownBlocks.get(pos);
+            if (id != null) found.add(new FoundBlock(id, pos.getX(), pos.getY(), pos.getZ()));
+        }
+        return found;
+    }
+
+    // Unload-then-add replaces a column on the overlay in one ordered write
+    private void sendColumns(List<ChunkPos> dropped, Map<ChunkPos, List<FoundBlock>> resent) {
+        sendBlockData(out -> {
+            for (ChunkPos cPos : dropped) {
+                writeChunkUnload(out, cPos.x, cPos.z);
+            }
+            for (Map.Entry<ChunkPos, List<FoundBlock>> entry : resent.entrySet()) {
+                writeChunkUnload(out, entry.getKey().x, entry.getKey().z);
+                if (!entry.getValue().isEmpty()) {
+                    writeSections(out, entry.getValue());
+                }
+            }
+        });
+    }
+
+    // The overlay has a cache for this world (kept across a reconnect, or from disk after a world
+    // change) and sent a hash per column: replace only the loaded columns that differ. Cached
+    // columns not loaded here yet are compared when they load (scanChunk), or dropped if they are
+    // outside the interest area.
+    public void handleManifest(Map<ChunkPos, Long> manifest) {
+        submitScan(() -> {
+            long start = System.nanoTime();
+            resyncPending = false;
+            overlayHashes.clear();
+            Set<ChunkPos> columns = new HashSet<>(manifest.keySet());
+            columns.addAll(sentChunks);
+
+            List<ChunkPos> dropped = new ArrayList<>();
+            Map<ChunkPos, List<FoundBlock>> resent = new HashMap<>();
+            int matched = 0;
+            for (ChunkPos cPos : columns) {
+                if (!sentChunks.contains(cPos)) {
+                    if (isSubscribed(cPos)) {
+                        overlayHashes.put(cPos, manifest.get(cPos));
+                    } else {
+                        dropped.add(cPos);
+                    }
+                    continue;
+                }
+
+                List<BlockPos> blocks = sortedColumn(cPos);
+                if (manifest.getOrDefault(cPos, FNV_BASIS) == columnHash(blocks)) {
+                    matched++;
+                    continue;
+                }
+                resent.put(cPos, foundBlocks(blocks));
+            }
+
+            System.out.println("[BlockESP] Resync: " + matched + " columns match, " + resent.size() + " resent, "
+                    + overlayHashes.size() + " pending, " + dropped.size() + " dropped (" + (System.nanoTime() - start) / 1000 + "us)");
+            if (dropped.isEmpty() && resent.isEmpty()) return;
+            sendColumns(dropped, resent);
+        });
+    }
     
     public void clear() {
         knownBlocks.clear();
         chunkCache.clear();
         sentChunks.clear();
+        evictedChunks.clear();
+        overlayHashes.clear();
     }
 }
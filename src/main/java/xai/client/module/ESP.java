@@ -9,6 +9,7 @@ import net.minecraft.world.entity.Entity;
 import net.minecraft.world.entity.LivingEntity;
 import net.minecraft.world.entity.player.Player;
 import net.minecraft.world.phys.Vec3;
+import org.joml.Matrix4f;
 
 import java.io.IOException;
 import java.lang.reflect.Method;
@@ -92,6 +93,14 @@ public class ESP {
             }
             
             final double finalFov = fov;
+
+            // The frame's actual view-projection (camera-relative, includes bobbing/nausea), column-major.
+            // The overlay falls back to yaw/pitch/fov when it is missing.
+            float[] viewProj = null;
+            if (context.projectionMatrix() != null && context.positionMatrix() != null) {
+                viewProj = new Matrix4f(context.projectionMatrix()).mul(context.positionMatrix()).get(new float[16]);
+            }
+            final float[] finalViewProj = viewProj;
             final boolean screenOpen = client.screen != null;
             final Player localPlayer = client.player;
 
@@ -176,6 +185,11 @@ public class ESP {
                     out.writeDouble(camPos.z);
                     
                     out.writeFloat((float) finalFov);
+
+                    out.writeBoolean(finalViewProj != null);
+                    if (finalViewProj != null) {
+                        for (float v : finalViewProj) out.writeFloat(v);
+                    }
                     
                     out.writeBoolean(screenOpen);
 